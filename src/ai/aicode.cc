@@ -44,6 +44,7 @@
 #include "object/objcollide.hh"
 #include "object/object.hh"
 #include "object/objectdock.hh"
+#include "object/objectgrid.hh"
 #include "object/objectshield.hh"
 #include "object/waypoint.hh"
 #include "parse/parselo.hh"
@@ -2112,7 +2113,6 @@ int get_nearest_objnum (
     int max_attackers, int ship_info_index) {
     object* danger_weapon_objp;
     ai_info* aip;
-    ship_obj* so;
 
     // initialize eno struct
     eval_nearest_objnum eno;
@@ -2126,10 +2126,17 @@ int get_nearest_objnum (
     eno.nearest_objnum = -1;
     eno.check_danger_weapon_objnum = 0;
 
-    // go through the list of all ships and evaluate as potential targets
-    for (so = GET_FIRST (&Ship_obj_list); so != END_OF_LIST (&Ship_obj_list);
-         so = GET_NEXT (so)) {
-        eno.trial_objp = &Objects[so->objnum];
+    // go through the ships in range and evaluate them as potential targets;
+    // fighters and bombers count at half their distance, so they can be
+    // chosen from twice as far
+    std::vector< int > candidates;
+
+    obj_grid_query_sphere (
+        &Objects[objnum].pos, 2.0f * range * OBJ_GRID_QUICK_DIST_SCALE,
+        OBJ_GRID_TYPE (OBJ_SHIP), enemy_team_mask, candidates);
+
+    for (int candidate : candidates) {
+        eno.trial_objp = &Objects[candidate];
         evaluate_object_as_nearest_objnum (&eno);
     }
 
@@ -2189,16 +2196,20 @@ int find_nearby_threat (
     int nearest_objnum;
     float nearest_dist;
     object* objp;
-    ship_obj* so;
 
     nearest_objnum = -1;
     nearest_dist = range;
 
     *count = 0;
 
-    for (so = GET_FIRST (&Ship_obj_list); so != END_OF_LIST (&Ship_obj_list);
-         so = GET_NEXT (so)) {
-        objp = &Objects[so->objnum];
+    std::vector< int > candidates;
+
+    obj_grid_query_sphere (
+        &Objects[objnum].pos, range * OBJ_GRID_QUICK_DIST_SCALE,
+        OBJ_GRID_TYPE (OBJ_SHIP), enemy_team_mask, candidates);
+
+    for (int candidate : candidates) {
+        objp = &Objects[candidate];
 
         if (OBJ_INDEX (objp) != objnum) {
             if (Ships[objp->instance].flags[Ship::Ship_Flags::Dying]) continue;
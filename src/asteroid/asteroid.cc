@@ -23,6 +23,7 @@
 #include "model/model.hh"
 #include "object/objcollide.hh"
 #include "object/object.hh"
+#include "object/objectgrid.hh"
 #include "parse/parselo.hh"
 #include "particle/particle.hh"
 #include "render/3d.hh"
@@ -1307,7 +1308,6 @@ static void asteroid_explode_sound (object* objp, int type, int play_loud) {
 static void asteroid_do_area_effect (object* asteroid_objp) {
     object* ship_objp;
     float damage, blast;
-    ship_obj* so;
     asteroid* asp;
     asteroid_info* asip;
 
@@ -1318,9 +1318,14 @@ static void asteroid_do_area_effect (object* asteroid_objp) {
         return;
     }
 
-    for (so = GET_FIRST (&Ship_obj_list); so != END_OF_LIST (&Ship_obj_list);
-         so = GET_NEXT (so)) {
-        ship_objp = &Objects[so->objnum];
+    std::vector< int > candidates;
+
+    obj_grid_query_sphere (
+        &asteroid_objp->pos, asip->outer_rad * OBJ_GRID_QUICK_DIST_SCALE,
+        OBJ_GRID_TYPE (OBJ_SHIP), OBJ_GRID_ALL_TEAMS, candidates);
+
+    for (int objnum : candidates) {
+        ship_objp = &Objects[objnum];
 
         // don't blast navbuoys
         if (ship_get_SIF (ship_objp->instance)[Ship::Info_Flags::Navbuoy]) {
@@ -13,6 +13,7 @@
 #include <cctype>
 #include <climits>
 #include <iomanip>
+#include <map>
 #include <memory>
 
 #include "anim/animplay.hh"
@@ -32,6 +33,7 @@
 #include "shared/globals.hh"
 #include "ship/ship.hh"
 #include "tgautils/tgautils.hh"
+#include "tracing/MemoryAccount.hh"
 #include "tracing/Monitor.hh"
 #include "tracing/tracing.hh"
 
@@ -66,6 +68,25 @@ int MISCMAP = -1;
 int AMBIENTMAP = -1;
 
 size_t bm_texture_ram = 0;
+
+static tracing::MemoryAccount Bitmap_memory ("Bitmaps");
+
+// The bitmap data held in memory is counted in bm_texture_ram and reported to
+// the memory accounts, one object per bitmap with data
+static void bm_texture_ram_add (size_t size) {
+    if (size == 0) { return; }
+
+    bm_texture_ram += size;
+    Bitmap_memory.add (size);
+}
+
+static void bm_texture_ram_remove (size_t size) {
+    if (size == 0) { return; }
+
+    bm_texture_ram -= size;
+    Bitmap_memory.remove (size);
+}
+
 int Bm_paging = 0;
 
 // Extension type lists
@@ -667,7 +688,7 @@ void bm_free_data (bitmap_slot* bs, bool release) {
     // BmpMan isn't the one in charge of allocating/deallocing them.
     if (be->type == BM_TYPE_USER) {
 #ifdef BMPMAN_NDEBUG
-        if (be->data_size != 0) bm_texture_ram -= be->data_size;
+        bm_texture_ram_remove (be->data_size);
 #endif
         goto SkipFree;
     }
@@ -676,14 +697,14 @@ void bm_free_data (bitmap_slot* bs, bool release) {
     // the freeing it part of this.
     if (bmp->data == 0) {
 #ifdef BMPMAN_NDEBUG
-        if (be->data_size != 0) bm_texture_ram -= be->data_size;
+        bm_texture_ram_remove (be->data_size);
 #endif
         goto SkipFree;
     }
 
     // Free up the data now!
 #ifdef BMPMAN_NDEBUG
-    bm_texture_ram -= be->data_size;
+    bm_texture_ram_remove (be->data_size);
 #endif
     free ((void*)bmp->data);
 
@@ -719,7 +740,7 @@ void bm_free_data_fast (int handle) {
     // BmpMan isn't the one in charge of allocating/deallocing them.
     if (be->type == BM_TYPE_USER) {
 #ifdef BMPMAN_NDEBUG
-        if (be->data_size != 0) bm_texture_ram -= be->data_size;
+        bm_texture_ram_remove (be->data_size);
 #endif
         return;
     }
@@ -729,7 +750,7 @@ void bm_free_data_fast (int handle) {
     if (bmp->data == 0) {
 #ifdef BMPMAN_NDEBUG
         if (be->data_size != 0) {
-            bm_texture_ram -= be->data_size;
+            bm_texture_ram_remove (be->data_size);
             be->data_size = 0;
         }
 #endif
@@ -738,7 +759,7 @@ void bm_free_data_fast (int handle) {
 
     // Free up the data now!
 #ifdef BMPMAN_NDEBUG
-    bm_texture_ram -= be->data_size;
+    bm_texture_ram_remove (be->data_size);
     be->data_size = 0;
 #endif
     free ((void*)bmp->data);
@@ -2500,7 +2521,7 @@ void* bm_malloc (int n, size_t size) {
     auto entry = bm_get_entry (n);
     ASSERT (entry->data_size == 0);
     entry->data_size += size;
-    bm_texture_ram += size;
+    bm_texture_ram_add (size);
 #endif
 
     return malloc (size);
@@ -2542,9 +2563,53 @@ void bm_page_in_start () {
     gr_bm_page_in_start ();
 }
 
+// Reads ahead the files of the bitmaps used in the level, by the directory
+// type they were loaded from, so that the disk reads the next files while the
+// first ones are decoded
+static void bm_page_in_prefetch () {
+    std::map< int, std::vector< std::string > > files;
+
+    for (auto& block : bm_blocks) {
+        for (auto& slot : block) {
+            auto& entry = slot.entry;
+
+            if (!entry.preloaded || entry.type == BM_TYPE_NONE ||
+                entry.type == BM_TYPE_USER ||
+                entry.type == BM_TYPE_RENDER_TARGET_DYNAMIC ||
+                entry.type == BM_TYPE_RENDER_TARGET_STATIC) {
+                continue;
+            }
+
+            if (entry.type == BM_TYPE_EFF) {
+                // Every frame is an image of its own, named without the
+                // extension of its type
+                for (int i = 0; i < BM_NUM_TYPES; i++) {
+                    if (bm_type_list[i] == entry.info.ani.eff.type) {
+                        files[entry.dir_type].push_back (
+                            std::string (entry.info.ani.eff.filename) +
+                            bm_ext_list[i]);
+                        break;
+                    }
+                }
+            }
+            else if (
+                !bm_is_anim (&entry) ||
+                entry.info.ani.first_frame == entry.handle) {
+                // The later frames of an ANI or APNG are read from the file
+                // of the first one
+                files[entry.dir_type].push_back (entry.filename);
+            }
+        }
+    }
+
+    for (auto& dir : files) { cf_prefetch (dir.second, dir.first); }
+}
+
 void bm_page_in_stop () {
     TRACE_SCOPE (tracing::PageInStop);
 
+    bm_page_in_prefetch ();
+
     II << "loading all used bitmaps";
 
     // Load all the ones that are supposed to be loaded for this level.
@@ -2592,6 +2657,9 @@ void bm_page_in_stop () {
 
     II << "Loaded " << n << " bitmaps used in this level";
 
+    // Whatever is left is not needed anymore
+    cf_prefetch_cancel ();
+
     Bm_paging = 0;
 }
 
@@ -3181,7 +3249,7 @@ void bm_update_memory_used (int n, size_t size) {
     auto entry = bm_get_entry (n);
     ASSERT (entry->data_size == 0);
     entry->data_size += size;
-    bm_texture_ram += size;
+    bm_texture_ram_add (size);
 #endif
 }
 
@@ -14,11 +14,18 @@
 #include <cstring>
 #include <cstdio>
 #include <cerrno>
+#include <atomic>
 #include <limits>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "cfile/cfile.hh"
 #include "cfile/cfilearchive.hh"
 #include "cfile/cfilesystem.hh"
+#include "io/timer.hh"
 #include "osapi/osapi.hh"
 #include "parse/encrypt.hh"
 #include "cfilesystem.hh"
@@ -83,8 +90,43 @@ static int Cfile_stack_pos = 0;
 
 static char Cfile_stack[CFILE_STACK_MAX][CFILE_ROOT_DIRECTORY_LEN];
 
-Cfile_block Cfile_block_list[MAX_CFILE_BLOCKS];
-static CFILE Cfile_list[MAX_CFILE_BLOCKS];
+//
+// The pool of the blocks of the open files. The chunks are allocated as the
+// open files outgrow them and the free blocks are kept in a list; both are
+// guarded by the mutex, so that files may be opened and closed from any
+// thread. A block is only used by the thread that holds its file.
+//
+struct cfile_chunk {
+    Cfile_block blocks[CFILE_BLOCKS_PER_CHUNK];
+    CFILE files[CFILE_BLOCKS_PER_CHUNK];
+};
+
+static std::mutex Cfile_blocks_mutex;
+static std::atomic< cfile_chunk* > Cfile_chunks[MAX_CFILE_CHUNKS];
+static std::atomic< int > Cfile_num_blocks{ 0 };
+static std::vector< int > Cfile_free_blocks;
+
+Cfile_block* cf_get_cfile_block (int id) {
+    ASSERT (id >= 0 && id < Cfile_num_blocks);
+
+    cfile_chunk* chunk = Cfile_chunks[id / CFILE_BLOCKS_PER_CHUNK];
+    return &chunk->blocks[id % CFILE_BLOCKS_PER_CHUNK];
+}
+
+static CFILE* cf_get_cfile (int id) {
+    cfile_chunk* chunk = Cfile_chunks[id / CFILE_BLOCKS_PER_CHUNK];
+    return &chunk->files[id % CFILE_BLOCKS_PER_CHUNK];
+}
+
+// Records the open of the file at the location, a failed one if cfp is NULL
+static void cf_record_cfile (
+    CFILE* cfp, const char* name, const CFileLocation& location,
+    const char* source, int line, std::uint64_t start) {
+    const auto record = cf_record_open (
+        name, cfp ? &location : nullptr, source, line, start);
+
+    if (cfp) { cf_get_cfile_block (cfp->id)->record = record; }
+}
 
 static const char* Cfile_cdrom_dir = NULL;
 
@@ -102,23 +144,124 @@ static CFILE* cf_open_memory_fill_cfblock (
 
 static CFILE*
 cf_open_mapped_fill_cfblock (const char* source, int line, FILE* fp, int type);
+static CFILE* cf_open_pack_view (
+    const char* source, int line, const char* pack_path, size_t offset,
+    size_t size, int dir_type);
 
 static void cf_chksum_long_init ();
 
-static void dump_opened_files () {
-    for (int i = 0; i < MAX_CFILE_BLOCKS; i++) {
-        auto cb = &Cfile_block_list[i];
+// Called with the blocks mutex held
+static void dump_opened_files_locked () {
+    for (int i = 0; i < Cfile_num_blocks; i++) {
+        auto cb = cf_get_cfile_block (i);
         if (cb->type != CFILE_BLOCK_UNUSED) {
-            WARNINGF (LOCATION, "    %s:%d", cb->source_file, cb->line_num);
+            std::ostringstream owner;
+            owner << cb->owner;
+
+            WARNINGF (LOCATION, "    %s:%d (thread %s)", cb->source_file, cb->line_num, owner.str ().c_str ());
         }
     }
 }
 
+static void dump_opened_files () {
+    std::lock_guard< std::mutex > guard (Cfile_blocks_mutex);
+    dump_opened_files_locked ();
+}
+
+//
+// Pack files are mapped whole the first time one of their files is opened and
+// stay mapped for the life of the process; the files in them are opened as
+// views of the mapping, read with no copy into a stream buffer nor system
+// call.
+//
+struct cf_pack_mapping {
+    void* data;
+    size_t length;
+};
+
+static std::mutex Pack_mappings_mutex;
+static std::unordered_map< std::string, cf_pack_mapping > Pack_mappings;
+
+// Returns the mapping of the pack, or a null mapping if it cannot be mapped
+static cf_pack_mapping cf_map_pack (const char* pack_path) {
+    std::lock_guard< std::mutex > guard (Pack_mappings_mutex);
+
+    auto iter = Pack_mappings.find (pack_path);
+    if (iter != Pack_mappings.end ()) { return iter->second; }
+
+    cf_pack_mapping mapping = { nullptr, 0 };
+
+    FILE* fp = fopen (pack_path, "rb");
+
+    if (fp) {
+        mapping.length = cfilelength (fileno (fp));
+
+        if (mapping.length) {
+            mapping.data = mmap (
+                NULL, mapping.length, PROT_READ, MAP_SHARED, fileno (fp), 0);
+
+            if (mapping.data == MAP_FAILED) {
+                WARNINGF (LOCATION, "Cannot map pack file %s, reading it instead",pack_path);
+                mapping.data = nullptr;
+            }
+        }
+
+        fclose (fp);
+    }
+
+    if (mapping.data == nullptr) { mapping.length = 0; }
+
+    // Failures are remembered too, so that a pack is only tried once
+    Pack_mappings[pack_path] = mapping;
+
+    return mapping;
+}
+
+// True if an open file is a view of the mapping; called with the blocks mutex
+// held
+static bool cf_pack_mapping_in_use (const cf_pack_mapping& mapping) {
+    const char* first = (const char*)mapping.data;
+    const char* last = first + mapping.length;
+
+    for (int i = 0; i < Cfile_num_blocks; i++) {
+        auto cb = cf_get_cfile_block (i);
+        const char* data = (const char*)cb->data;
+
+        if (cb->type != CFILE_BLOCK_UNUSED && data >= first && data < last) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Unmaps the packs; those with files still open in them stay mapped, for the
+// files not to be left pointing at unmapped memory
+static void cf_unmap_packs () {
+    std::lock_guard< std::mutex > blocks_guard (Cfile_blocks_mutex);
+    std::lock_guard< std::mutex > guard (Pack_mappings_mutex);
+
+    for (auto& mapping : Pack_mappings) {
+        if (mapping.second.data == nullptr) { continue; }
+
+        if (cf_pack_mapping_in_use (mapping.second)) {
+            WARNINGF (LOCATION, "Pack file %s still has open files, leaving it mapped",mapping.first.c_str ());
+            continue;
+        }
+
+        munmap (mapping.second.data, mapping.second.length);
+    }
+
+    Pack_mappings.clear ();
+}
+
 void cfile_close () {
     WARNINGF (LOCATION, "Still opened files:");
     dump_opened_files ();
 
+    cf_prefetch_shutdown ();
     cf_free_secondary_filelist ();
+    cf_unmap_packs ();
 
     cfile_inited = 0;
 }
@@ -172,7 +315,6 @@ int cfile_init (const char* exe_dir, const char* cdrom_dir) {
 
     strncpy (buf, exe_dir, CFILE_ROOT_DIRECTORY_LEN - 1);
     buf[CFILE_ROOT_DIRECTORY_LEN - 1] = '\0';
-    size_t i = strlen (buf);
 
     // are we in a root directory?
     if (cfile_in_root_dir (buf)) {
@@ -201,10 +343,6 @@ int cfile_init (const char* exe_dir, const char* cdrom_dir) {
     strcpy (Cfile_root_dir, buf);
     strcpy (Cfile_user_dir, fs2::os::get_config_path ().c_str ());
 
-    for (i = 0; i < MAX_CFILE_BLOCKS; i++) {
-        Cfile_block_list[i].type = CFILE_BLOCK_UNUSED;
-    }
-
     // 32 bit CRC table init
     cf_chksum_long_init ();
 
@@ -626,6 +764,8 @@ CFILE* _cfopen (
                                        // cf_find_file_location
     strcpy (copy_file_path, file_path);
 
+    const auto start = Cfile_recording ? timer_get_nanoseconds () : 0;
+
     auto find_res = cf_find_file_location (
         copy_file_path, dir_type, localize, location_flags);
     if (find_res.found) {
@@ -633,24 +773,43 @@ CFILE* _cfopen (
         II << "found " << file_path << " : " << find_res.full_name;
 
         if (type & CFILE_MEMORY_MAPPED) {
-            // Can't open memory mapped files out of pack or memory files
+            CFILE* cfp = NULL;
+
+            // Files in pack files are views of the mapping of the pack
+            if (find_res.offset != 0 && find_res.data_ptr == nullptr) {
+                cfp = cf_open_pack_view (
+                    source, line, find_res.full_name.c_str (), find_res.offset,
+                    find_res.size, dir_type);
+            }
+
+            // Can't open memory mapped files out of memory files
             if (find_res.offset == 0 && find_res.data_ptr != nullptr) {
                 FILE* fp = fopen (find_res.full_name.c_str (), "rb");
                 if (fp) {
-                    return cf_open_mapped_fill_cfblock (
+                    cfp = cf_open_mapped_fill_cfblock (
                         source, line, fp, dir_type);
                 }
             }
+
+            if (Cfile_recording) {
+                cf_record_cfile (cfp, file_path, find_res, source, line, start);
+            }
+
+            return cfp;
         }
         else {
             // since cfopen_special already has all the code to handle the
-            // opening we can just use that here
+            // opening, and the recording, we can just use that here
             return _cfopen_special (
                 source, line, find_res.full_name.c_str (), mode, find_res.size,
                 find_res.offset, find_res.data_ptr, dir_type);
         }
     }
 
+    if (Cfile_recording) {
+        cf_record_open (file_path, nullptr, source, line, start);
+    }
+
     return NULL;
 }
 
@@ -668,7 +827,7 @@ CFILE* _cfopen (
 // returns:             success ==> address of CFILE structure
 // error   ==> NULL
 //
-CFILE* _cfopen_special (
+static CFILE* cf_open_special (
     const char* source, int line, const char* file_path, const char* mode,
     const size_t size, const size_t offset, const void* data, int dir_type) {
     if (!cfile_inited) {
@@ -692,6 +851,13 @@ CFILE* _cfopen_special (
             source, line, data, size, dir_type);
     }
     else {
+        if (offset) {
+            // Found it in a pack file, read it from the mapping if possible
+            CFILE* cfp = cf_open_pack_view (
+                source, line, file_path, offset, size, dir_type);
+            if (cfp) { return cfp; }
+        }
+
         // "file_path" should already be a fully qualified path, so just try to
         // open it
         FILE* fp = fopen (file_path, "rb");
@@ -712,6 +878,31 @@ CFILE* _cfopen_special (
     return NULL;
 }
 
+CFILE* _cfopen_special (
+    const char* source, int line, const char* file_path, const char* mode,
+    const size_t size, const size_t offset, const void* data, int dir_type) {
+    if (!Cfile_recording) {
+        return cf_open_special (
+            source, line, file_path, mode, size, offset, data, dir_type);
+    }
+
+    const auto start = timer_get_nanoseconds ();
+
+    CFILE* cfp = cf_open_special (
+        source, line, file_path, mode, size, offset, data, dir_type);
+
+    // The record takes the name the file was looked up by, if it was
+    CFileLocation location (true);
+    location.full_name = file_path;
+    location.size = size;
+    location.offset = offset;
+    location.data_ptr = data;
+
+    cf_record_cfile (cfp, file_path, location, source, line, start);
+
+    return cfp;
+}
+
 // ------------------------------------------------------------------------
 // ctmpfile()
 //
@@ -730,37 +921,61 @@ CFILE* ctmpfile () {
         return NULL;
 }
 
-// cfget_cfile_block() will try to find an empty Cfile_block structure in the
-// Cfile_block_list[] array and return the index.
+// cfget_cfile_block() will take a free Cfile_block structure from the pool,
+// growing the pool if none is free, and return its index.
 //
-// returns:   success ==> index in Cfile_block_list[] array
+// returns:   success ==> index of the Cfile_block
 // failure ==> -1
 //
 static int cfget_cfile_block () {
-    int i;
-    Cfile_block* cb;
+    std::lock_guard< std::mutex > guard (Cfile_blocks_mutex);
 
-    for (i = 0; i < MAX_CFILE_BLOCKS; i++) {
-        cb = &Cfile_block_list[i];
-        if (cb->type == CFILE_BLOCK_UNUSED) {
-            cb->data = NULL;
-            cb->fp = NULL;
-            cb->type = CFILE_BLOCK_USED;
-            return i;
+    if (Cfile_free_blocks.empty () && Cfile_num_blocks < MAX_CFILE_BLOCKS) {
+        const int first = Cfile_num_blocks;
+
+        Cfile_chunks[first / CFILE_BLOCKS_PER_CHUNK] = new cfile_chunk ();
+        Cfile_num_blocks = first + CFILE_BLOCKS_PER_CHUNK;
+
+        // The lowest ids are taken first
+        for (int i = Cfile_num_blocks - 1; i >= first; i--) {
+            Cfile_free_blocks.push_back (i);
         }
     }
 
+    if (!Cfile_free_blocks.empty ()) {
+        const int i = Cfile_free_blocks.back ();
+        Cfile_free_blocks.pop_back ();
+
+        Cfile_block* cb = cf_get_cfile_block (i);
+        cb->data = NULL;
+        cb->fp = NULL;
+        cb->owner = std::this_thread::get_id ();
+        cb->record = -1;
+        cb->bytes_read = 0;
+        cb->type = CFILE_BLOCK_USED;
+
+        return i;
+    }
+
     // If we've reached this point, a free Cfile_block could not be found
     WARNINGF (LOCATION, "A free Cfile_block could not be found.");
 
     // Dump a list of all opened files
     WARNINGF (LOCATION, "Out of cfile blocks! Currently opened files:");
-    dump_opened_files ();
+    dump_opened_files_locked ();
 
     ASSERT (0);
     return -1;
 }
 
+// Returns the block to the pool
+static void cfrelease_cfile_block (int id) {
+    std::lock_guard< std::mutex > guard (Cfile_blocks_mutex);
+
+    cf_get_cfile_block (id)->type = CFILE_BLOCK_UNUSED;
+    Cfile_free_blocks.push_back (id);
+}
+
 // cfclose() closes the file
 //
 // returns:   success ==> 0
@@ -772,7 +987,7 @@ int cfclose (CFILE* cfile) {
     ASSERT (cfile != NULL);
     Cfile_block* cb;
     ASSERT (cfile->id >= 0 && cfile->id < MAX_CFILE_BLOCKS);
-    cb = &Cfile_block_list[cfile->id];
+    cb = cf_get_cfile_block (cfile->id);
 
     result = 0;
     if (cb->data && cb->mem_mapped) {
@@ -793,7 +1008,9 @@ int cfclose (CFILE* cfile) {
         // VP  do nothing
     }
 
-    cb->type = CFILE_BLOCK_UNUSED;
+    cf_record_close (cb->record, cb->bytes_read);
+
+    cfrelease_cfile_block (cfile->id);
     return result;
 }
 
@@ -802,10 +1019,10 @@ int cf_is_valid (CFILE* cfile) {
     if (cfile == NULL) return 0;
 
     // Does it have a valid ID?
-    if (cfile->id < 0 || cfile->id >= MAX_CFILE_BLOCKS) return 0;
+    if (cfile->id < 0 || cfile->id >= Cfile_num_blocks) return 0;
 
     // Is it used?
-    Cfile_block* cb = &Cfile_block_list[cfile->id];
+    Cfile_block* cb = cf_get_cfile_block (cfile->id);
     if (cb->type != CFILE_BLOCK_USED && (cb->fp != NULL || cb->data != NULL))
         return 0;
 
@@ -814,7 +1031,7 @@ int cf_is_valid (CFILE* cfile) {
 }
 
 // cf_open_fill_cfblock() will fill up a Cfile_block element in the
-// Cfile_block_list[] array for the case of a file being opened by cf_open();
+// pool for the case of a file being opened by cf_open();
 //
 // returns:   success ==> ptr to CFILE structure.
 // error   ==> NULL
@@ -831,8 +1048,8 @@ cf_open_fill_cfblock (const char* source, int line, FILE* fp, int type) {
     else {
         CFILE* cfp;
         Cfile_block* cfbp;
-        cfbp = &Cfile_block_list[cfile_block_index];
-        cfp = &Cfile_list[cfile_block_index];
+        cfbp = cf_get_cfile_block (cfile_block_index);
+        cfp = cf_get_cfile (cfile_block_index);
         cfp->id = cfile_block_index;
         cfp->version = 0;
         cfbp->data = NULL;
@@ -853,7 +1070,7 @@ cf_open_fill_cfblock (const char* source, int line, FILE* fp, int type) {
 }
 
 // cf_open_packed_cfblock() will fill up a Cfile_block element in the
-// Cfile_block_list[] array for the case of a file being opened by cf_open();
+// pool for the case of a file being opened by cf_open();
 //
 // returns:   success ==> ptr to CFILE structure.
 // error   ==> NULL
@@ -872,9 +1089,9 @@ static CFILE* cf_open_packed_cfblock (
     else {
         CFILE* cfp;
         Cfile_block* cfbp;
-        cfbp = &Cfile_block_list[cfile_block_index];
+        cfbp = cf_get_cfile_block (cfile_block_index);
 
-        cfp = &Cfile_list[cfile_block_index];
+        cfp = cf_get_cfile (cfile_block_index);
         cfp->id = cfile_block_index;
         cfp->version = 0;
         cfbp->data = NULL;
@@ -893,7 +1110,7 @@ static CFILE* cf_open_packed_cfblock (
 }
 
 // cf_open_mapped_fill_cfblock() will fill up a Cfile_block element in the
-// Cfile_block_list[] array for the case of a file being opened by
+// pool for the case of a file being opened by
 // cf_open_mapped();
 //
 // returns:   ptr CFILE structure.
@@ -910,9 +1127,9 @@ static CFILE* cf_open_mapped_fill_cfblock (
     else {
         CFILE* cfp;
         Cfile_block* cfbp;
-        cfbp = &Cfile_block_list[cfile_block_index];
+        cfbp = cf_get_cfile_block (cfile_block_index);
 
-        cfp = &Cfile_list[cfile_block_index];
+        cfp = cf_get_cfile (cfile_block_index);
         cfp->id = cfile_block_index;
         cfp->version = 0;
         cfbp->max_read_len = 0;
@@ -952,9 +1169,9 @@ static CFILE* cf_open_memory_fill_cfblock (
     else {
         CFILE* cfp;
         Cfile_block* cfbp;
-        cfbp = &Cfile_block_list[cfile_block_index];
+        cfbp = cf_get_cfile_block (cfile_block_index);
 
-        cfp = &Cfile_list[cfile_block_index];
+        cfp = cf_get_cfile (cfile_block_index);
         cfp->id = cfile_block_index;
         cfp->version = 0;
         cfbp->max_read_len = 0;
@@ -972,8 +1189,28 @@ static CFILE* cf_open_memory_fill_cfblock (
     }
 }
 
+// cf_open_pack_view() opens a file in a pack file as a view of the mapping of
+// the pack
+//
+// returns:   success ==> ptr to CFILE structure.
+// error   ==> NULL, if the pack cannot be mapped
+//
+static CFILE* cf_open_pack_view (
+    const char* source, int line, const char* pack_path, size_t offset,
+    size_t size, int dir_type) {
+    const cf_pack_mapping mapping = cf_map_pack (pack_path);
+
+    if (mapping.data == nullptr || offset > mapping.length ||
+        size > mapping.length - offset) {
+        return NULL;
+    }
+
+    return cf_open_memory_fill_cfblock (
+        source, line, (const char*)mapping.data + offset, size, dir_type);
+}
+
 int cf_get_dir_type (CFILE* cfile) {
-    return Cfile_block_list[cfile->id].dir_type;
+    return cf_get_cfile_block (cfile->id)->dir_type;
 }
 
 // cf_returndata() returns the data pointer for a memory-mapped file that is
@@ -985,11 +1222,32 @@ const void* cf_returndata (CFILE* cfile) {
     ASSERT (cfile != NULL);
     Cfile_block* cb;
     ASSERT (cfile->id >= 0 && cfile->id < MAX_CFILE_BLOCKS);
-    cb = &Cfile_block_list[cfile->id];
+    cb = cf_get_cfile_block (cfile->id);
     ASSERT (cb->data != NULL);
     return cb->data;
 }
 
+const void* cf_returndata_span (CFILE* cfile, size_t* size) {
+    ASSERT (cfile != NULL);
+    ASSERT (size != NULL);
+    Cfile_block* cb;
+    ASSERT (cfile->id >= 0 && cfile->id < MAX_CFILE_BLOCKS);
+    cb = cf_get_cfile_block (cfile->id);
+
+    if (cb->data == NULL) { return NULL; }
+
+    // Mapped files are not read with cfread, their position stays at 0
+    const size_t length = cb->mem_mapped ? cb->data_length : cb->size;
+
+    ASSERT (cb->raw_position <= length);
+    *size = length - cb->raw_position;
+
+    // The span is read in place of the file
+    cb->bytes_read += *size;
+
+    return (const char*)cb->data + cb->raw_position;
+}
+
 // version number of opened file.  Will be 0 unless you put something else here
 // after you open a file.  Once set, you can use minimum version numbers with
 // the read functions.
@@ -1005,7 +1263,7 @@ void cf_set_max_read_len (CFILE* cfile, size_t len) {
     ASSERT (cfile != NULL);
     ASSERT ((cfile->id >= 0) && (cfile->id < MAX_CFILE_BLOCKS));
 
-    Cfile_block* cb = &Cfile_block_list[cfile->id];
+    Cfile_block* cb = cf_get_cfile_block (cfile->id);
 
     if (len) { cb->max_read_len = cb->raw_position + len; }
     else {
@@ -1182,7 +1440,7 @@ int cfilelength (CFILE* cfile) {
     ASSERT (cfile != NULL);
     Cfile_block* cb;
     ASSERT (cfile->id >= 0 && cfile->id < MAX_CFILE_BLOCKS);
-    cb = &Cfile_block_list[cfile->id];
+    cb = cf_get_cfile_block (cfile->id);
 
     // TODO: return length of memory mapped file
     ASSERT (!cb->mem_mapped);
@@ -1208,7 +1466,7 @@ int cfwrite (const void* buf, int elsize, int nelem, CFILE* cfile) {
 
     if (buf == NULL || elsize == 0 || nelem == 0) return 0;
 
-    Cfile_block* cb = &Cfile_block_list[cfile->id];
+    Cfile_block* cb = cf_get_cfile_block (cfile->id);
 
     if (cb->lib_offset != 0) {
         ASSERTX (0, "Attempt to write to a VP file (unsupported)");
@@ -1246,7 +1504,7 @@ int cfwrite (const void* buf, int elsize, int nelem, CFILE* cfile) {
 int cfputc (int c, CFILE* cfile) {
     if (!cf_is_valid (cfile)) return EOF;
 
-    Cfile_block* cb = &Cfile_block_list[cfile->id];
+    Cfile_block* cb = cf_get_cfile_block (cfile->id);
 
     if (cb->lib_offset != 0) {
         ASSERTX (0, "Attempt to write character to a VP file (unsupported)");
@@ -1286,7 +1544,7 @@ int cfputs (const char* str, CFILE* cfile) {
 
     if (str == NULL) return EOF;
 
-    Cfile_block* cb = &Cfile_block_list[cfile->id];
+    Cfile_block* cb = cf_get_cfile_block (cfile->id);
 
     if (cb->lib_offset != 0) {
         ASSERTX (0, "Attempt to write character to a VP file (unsupported)");
@@ -1647,7 +1905,7 @@ int cflush (CFILE* cfile) {
     ASSERT (cfile != NULL);
     Cfile_block* cb;
     ASSERT (cfile->id >= 0 && cfile->id < MAX_CFILE_BLOCKS);
-    cb = &Cfile_block_list[cfile->id];
+    cb = cf_get_cfile_block (cfile->id);
 
     // not supported for memory mapped files
     ASSERT (!cb->data);
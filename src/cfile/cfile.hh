@@ -296,6 +296,12 @@ int cfeof (CFILE* cfile);
 // mapped files)
 const void* cf_returndata (CFILE* cfile);
 
+// Returns the data of the file from the current position on, and its size,
+// for files read from memory: mapped files, files in pack files and in-memory
+// files. The data is valid until the file is closed. Returns NULL for the
+// files read through a file stream.
+const void* cf_returndata_span (CFILE* cfile, size_t* size);
+
 // get the 2 byte checksum of the passed filename - return 0 if operation
 // failed, 1 if succeeded
 int cf_chksum_short (
@@ -470,6 +476,29 @@ CFileLocationExt cf_find_file_location_ext (
     const char* filename, const int ext_num, const char** ext_list,
     int pathtype, bool localize = false);
 
+// Reads files ahead into the page cache on a background thread, so that they
+// are opened and read later with no wait on the disk. The files are looked up
+// on the calling thread, like cfopen does, and queued after the files of the
+// earlier calls. Files in memory are skipped, as are the files past the bound
+// of the queue.
+void cf_prefetch (
+    const std::vector< std::string >& filespecs, int pathtype = CF_TYPE_ANY);
+
+// Drops the files not yet read ahead
+void cf_prefetch_cancel ();
+
+// Stops the prefetch thread; called by cfile_close
+void cf_prefetch_shutdown ();
+
+// Starts recording the files opened for reading, dropping the records of the
+// previous recording
+void cf_record_start ();
+
+// Stops recording and writes the manifest of the files opened, in the order
+// they were opened, with where they were found, the source location that
+// opened them, the time of the open and the bytes read from them
+void cf_record_stop (const char* filename, const char* mission);
+
 // Functions to change directories
 int cfile_chdir (const char* dir);
 
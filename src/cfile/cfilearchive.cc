@@ -24,7 +24,7 @@ void cf_init_lowlevel_read_code (
 
     Cfile_block* cb;
     ASSERT (cfile->id >= 0 && cfile->id < MAX_CFILE_BLOCKS);
-    cb = &Cfile_block_list[cfile->id];
+    cb = cf_get_cfile_block (cfile->id);
 
     cb->lib_offset = lib_offset;
     cb->raw_position = pos;
@@ -51,7 +51,7 @@ int cfeof (CFILE* cfile) {
 
     Cfile_block* cb;
     ASSERT (cfile->id >= 0 && cfile->id < MAX_CFILE_BLOCKS);
-    cb = &Cfile_block_list[cfile->id];
+    cb = cf_get_cfile_block (cfile->id);
 
     int result = 0;
 
@@ -79,7 +79,7 @@ int cftell (CFILE* cfile) {
     ASSERT (cfile != NULL);
     Cfile_block* cb;
     ASSERT (cfile->id >= 0 && cfile->id < MAX_CFILE_BLOCKS);
-    cb = &Cfile_block_list[cfile->id];
+    cb = cf_get_cfile_block (cfile->id);
 
 #if defined(CHECK_POSITION) && !defined(NDEBUG)
     if (cb->fp) {
@@ -107,7 +107,7 @@ int cfseek (CFILE* cfile, int offset, int where) {
     ASSERT (cfile != NULL);
     Cfile_block* cb;
     ASSERT (cfile->id >= 0 && cfile->id < MAX_CFILE_BLOCKS);
-    cb = &Cfile_block_list[cfile->id];
+    cb = cf_get_cfile_block (cfile->id);
 
     // TODO: seek to offset in memory mapped file
     ASSERT (!cb->mem_mapped);
@@ -166,7 +166,7 @@ int cfread (void* buf, int elsize, int nelem, CFILE* cfile) {
 
     if (buf == NULL || size <= 0) return 0;
 
-    Cfile_block* cb = &Cfile_block_list[cfile->id];
+    Cfile_block* cb = cf_get_cfile_block (cfile->id);
 
     if ((cb->raw_position + size) > cb->size) {
         ASSERTX (
@@ -200,6 +200,7 @@ int cfread (void* buf, int elsize, int nelem, CFILE* cfile) {
     }
     if (bytes_read > 0) {
         cb->raw_position += bytes_read;
+        cb->bytes_read += bytes_read;
         ASSERTX (
             cb->raw_position <= cb->size,
             "Invalid raw_position value detected!");
@@ -5,6 +5,12 @@
 
 #include "defs.hh"
 
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+struct CFileLocation;
+
 // The following Cfile_block data is private to cfile.cpp
 // DO NOT MOVE the Cfile_block* information to cfile.h / do not extern this
 // data
@@ -30,10 +36,37 @@ struct Cfile_block  {
 
     const char* source_file;
     int line_num;
+    std::thread::id owner; // the thread that opened the file
+
+    std::int64_t record; // of the asset recorder, -1 if not recorded
+    size_t bytes_read;
 };
 
-#define MAX_CFILE_BLOCKS 64
-extern Cfile_block Cfile_block_list[MAX_CFILE_BLOCKS];
+// The blocks are allocated in chunks, as more files are opened at once, and
+// never move nor are freed; a block is found from the id of its CFILE
+#define CFILE_BLOCKS_PER_CHUNK 64
+#define MAX_CFILE_CHUNKS 256 // Can open 64*256 = 16384 files at once
+#define MAX_CFILE_BLOCKS (CFILE_BLOCKS_PER_CHUNK * MAX_CFILE_CHUNKS)
+
+// Returns the block of the given id, which must be an allocated one
+Cfile_block* cf_get_cfile_block (int id);
+
+// The asset recorder, set between cf_record_start and cf_record_stop
+extern std::atomic< bool > Cfile_recording;
+
+// Notes a file found by name on this thread, for the open that follows it
+void cf_record_lookup (
+    const char* name, const CFileLocation& location, std::uint64_t start);
+
+// Records an open, started at the given time, of a file found at the
+// location, or not found if the location is NULL. Returns the record of the
+// open, -1 if not recording.
+std::int64_t cf_record_open (
+    const char* name, const CFileLocation* location, const char* source_file,
+    int line_num, std::uint64_t start);
+
+// Adds the bytes read from the file before it was closed to its record
+void cf_record_close (std::int64_t record, size_t bytes_read);
 
 // Called once to setup the low-level reading code.
 void cf_init_lowlevel_read_code (
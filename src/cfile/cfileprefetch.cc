@@ -0,0 +1,180 @@
+// -*- mode: c++; -*-
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "defs.hh"
+#include "cfile/cfile.hh"
+#include "log/log.hh"
+
+//
+// The prefetch thread takes the regions of the queued files, a whole loose
+// file or the slice of a pack file, and asks the kernel to read them ahead.
+// The data lands in the page cache, where the regular reads and the mappings
+// of the pack files find it.
+//
+
+// The most bytes queued at once, so that a large prefetch does not push out
+// of the page cache the files it read ahead first
+#define CF_PREFETCH_MAX_BYTES (size_t (1) << 30)
+
+namespace {
+
+struct prefetch_region {
+    std::string path;
+    size_t offset;
+    size_t size;
+};
+
+std::mutex prefetch_mutex;
+std::condition_variable prefetch_wake;
+
+std::deque< prefetch_region > prefetch_queue;
+size_t prefetch_queued_bytes = 0;
+
+// The regions queued since the queue was last empty, not to queue twice the
+// pack region of a file looked up under several names
+std::set< std::pair< std::string, size_t > > prefetch_queued;
+
+std::thread prefetch_thread;
+bool prefetch_quit = false;
+
+void prefetch_run () {
+    std::string open_path;
+    int fd = -1;
+
+    for (;;) {
+        prefetch_region region;
+
+        {
+            std::unique_lock< std::mutex > lock (prefetch_mutex);
+
+            if (prefetch_queue.empty ()) {
+                // Nothing left to read ahead, release the file
+                if (fd >= 0) {
+                    lock.unlock ();
+
+                    close (fd);
+                    fd = -1;
+                    open_path.clear ();
+
+                    lock.lock ();
+                }
+
+                prefetch_wake.wait (lock, []() {
+                    return prefetch_quit || !prefetch_queue.empty ();
+                });
+            }
+
+            if (prefetch_quit) { break; }
+
+            region = std::move (prefetch_queue.front ());
+            prefetch_queue.pop_front ();
+
+            prefetch_queued_bytes -= region.size;
+            if (prefetch_queue.empty ()) { prefetch_queued.clear (); }
+        }
+
+        // The regions of a pack follow each other, the pack is opened once
+        if (region.path != open_path) {
+            if (fd >= 0) { close (fd); }
+
+            open_path = region.path;
+            fd = open (open_path.c_str (), O_RDONLY);
+        }
+
+        if (fd >= 0) {
+            posix_fadvise (
+                fd, off_t (region.offset), off_t (region.size),
+                POSIX_FADV_WILLNEED);
+        }
+    }
+
+    if (fd >= 0) { close (fd); }
+}
+
+} // namespace
+
+void cf_prefetch (const std::vector< std::string >& filespecs, int pathtype) {
+    std::vector< prefetch_region > regions;
+    regions.reserve (filespecs.size ());
+
+    for (const auto& filespec : filespecs) {
+        if (filespec.empty ()) { continue; }
+
+        auto res = cf_find_file_location (filespec.c_str (), pathtype);
+
+        // In-memory files need no reading
+        if (!res.found || res.data_ptr != nullptr || res.size == 0) {
+            continue;
+        }
+
+        regions.push_back ({ res.full_name, res.offset, res.size });
+    }
+
+    size_t count = 0, bytes = 0;
+
+    {
+        std::lock_guard< std::mutex > guard (prefetch_mutex);
+
+        for (auto& region : regions) {
+            if (prefetch_queued_bytes + region.size > CF_PREFETCH_MAX_BYTES) {
+                break;
+            }
+
+            if (!prefetch_queued.emplace (region.path, region.offset).second) {
+                continue;
+            }
+
+            prefetch_queued_bytes += region.size;
+            bytes += region.size;
+            ++count;
+
+            prefetch_queue.push_back (std::move (region));
+        }
+
+        if (count && !prefetch_thread.joinable ()) {
+            prefetch_quit = false;
+            prefetch_thread = std::thread (prefetch_run);
+        }
+    }
+
+    if (count) {
+        prefetch_wake.notify_one ();
+
+        II << "prefetching " << count << " files, " << (bytes >> 10)
+           << " KB";
+    }
+}
+
+void cf_prefetch_cancel () {
+    std::lock_guard< std::mutex > guard (prefetch_mutex);
+
+    prefetch_queue.clear ();
+    prefetch_queued.clear ();
+    prefetch_queued_bytes = 0;
+}
+
+void cf_prefetch_shutdown () {
+    {
+        std::lock_guard< std::mutex > guard (prefetch_mutex);
+
+        prefetch_queue.clear ();
+        prefetch_queued.clear ();
+        prefetch_queued_bytes = 0;
+
+        prefetch_quit = true;
+    }
+
+    prefetch_wake.notify_one ();
+
+    if (prefetch_thread.joinable ()) { prefetch_thread.join (); }
+}
@@ -0,0 +1,229 @@
+// -*- mode: c++; -*-
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "defs.hh"
+#include "cfile/cfile.hh"
+#include "cfile/cfilearchive.hh"
+#include "io/timer.hh"
+#include "log/log.hh"
+
+//
+// The recorder of the files opened for reading, in the order they were
+// opened, with where they were found, who opened them, how long the lookup
+// and the open took and how much of them was read.
+//
+
+std::atomic< bool > Cfile_recording{ false };
+
+namespace {
+
+struct file_record {
+    std::string name;      // as given to cfopen
+    std::string full_name; // the loose file or the pack file
+    size_t offset;         // in the pack file, 0 for loose files
+    size_t size;
+    bool found;
+
+    const char* source_file;
+    int line_num;
+    std::string thread;
+
+    std::uint64_t open_time;     // since the start of the recording
+    std::uint64_t open_duration; // of the lookup and the open
+    size_t bytes_read;
+};
+
+std::mutex record_mutex;
+std::vector< file_record > records;
+
+// Tells the records of one recording from those of the previous ones
+std::int64_t record_session = 0;
+std::uint64_t record_start = 0;
+
+// The last file found by name on the thread. The opens of the full paths the
+// lookups return take the name, and the start, of the lookup.
+struct file_lookup {
+    std::string name;
+    std::string full_name;
+    size_t offset;
+    std::uint64_t start;
+};
+
+thread_local file_lookup last_lookup;
+
+void write_json_string (std::ostream& out, const std::string& s) {
+    out << '"';
+
+    for (auto c : s) {
+        switch (c) {
+        case '"': out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+
+        default:
+            if ((unsigned char)c < 0x20) {
+                char buf[8];
+                snprintf (buf, sizeof buf, "\\u%04x", c);
+                out << buf;
+            }
+            else {
+                out << c;
+            }
+            break;
+        }
+    }
+
+    out << '"';
+}
+
+} // namespace
+
+void cf_record_start () {
+    std::lock_guard< std::mutex > guard (record_mutex);
+
+    records.clear ();
+
+    ++record_session;
+    record_start = timer_get_nanoseconds ();
+
+    Cfile_recording = true;
+}
+
+void cf_record_stop (const char* filename, const char* mission) {
+    std::vector< file_record > done;
+
+    {
+        std::lock_guard< std::mutex > guard (record_mutex);
+
+        if (!Cfile_recording) { return; }
+
+        Cfile_recording = false;
+        done.swap (records);
+    }
+
+    std::ofstream out (filename);
+
+    if (!out) {
+        WARNINGF (LOCATION, "Cannot write the asset manifest %s", filename);
+        return;
+    }
+
+    size_t found = 0, bytes = 0;
+
+    out << "{\n  \"mission\": ";
+    write_json_string (out, mission);
+    out << ",\n  \"files\": [";
+
+    for (size_t i = 0; i < done.size (); ++i) {
+        const auto& record = done[i];
+
+        out << (i ? "," : "") << "\n    { \"name\": ";
+        write_json_string (out, record.name);
+        out << ", \"found\": " << (record.found ? "true" : "false");
+
+        if (record.found) {
+            out << ", \"path\": ";
+            write_json_string (out, record.full_name);
+            out << ", \"offset\": " << record.offset
+                << ", \"size\": " << record.size
+                << ", \"bytes_read\": " << record.bytes_read;
+
+            ++found;
+            bytes += record.bytes_read;
+        }
+
+        out << ", \"source\": ";
+        write_json_string (
+            out, std::string (record.source_file) + ":" +
+                     std::to_string (record.line_num));
+
+        out << ", \"thread\": ";
+        write_json_string (out, record.thread);
+
+        out << ", \"open_time_ns\": " << record.open_time
+            << ", \"open_duration_ns\": " << record.open_duration << " }";
+    }
+
+    out << "\n  ]\n}\n";
+
+    II << "asset manifest " << filename << ": " << done.size () << " opens, "
+       << found << " found, " << (bytes >> 10) << " KB read";
+}
+
+void cf_record_lookup (
+    const char* name, const CFileLocation& location, std::uint64_t start) {
+    last_lookup.name = name;
+    last_lookup.full_name = location.full_name;
+    last_lookup.offset = location.offset;
+    last_lookup.start = start;
+}
+
+std::int64_t cf_record_open (
+    const char* name, const CFileLocation* location, const char* source_file,
+    int line_num, std::uint64_t start) {
+    const auto now = timer_get_nanoseconds ();
+
+    file_record record;
+
+    record.name = name;
+    record.found = location && location->found;
+
+    if (record.found && !last_lookup.name.empty () &&
+        last_lookup.offset == location->offset &&
+        last_lookup.full_name == location->full_name) {
+        record.name = last_lookup.name;
+        start = (std::min) (start, last_lookup.start);
+    }
+
+    last_lookup.name.clear ();
+
+    if (record.found) {
+        record.full_name = location->full_name;
+        record.offset = location->offset;
+        record.size = location->size;
+    }
+    else {
+        record.offset = record.size = 0;
+    }
+
+    record.source_file = source_file;
+    record.line_num = line_num;
+
+    std::ostringstream thread;
+    thread << std::this_thread::get_id ();
+    record.thread = thread.str ();
+
+    record.open_duration = now - start;
+    record.bytes_read = 0;
+
+    std::lock_guard< std::mutex > guard (record_mutex);
+
+    if (!Cfile_recording) { return -1; }
+
+    record.open_time = start > record_start ? start - record_start : 0;
+    records.push_back (std::move (record));
+
+    return (record_session << 32) | std::int64_t (records.size () - 1);
+}
+
+void cf_record_close (std::int64_t record, size_t bytes_read) {
+    if (record < 0) { return; }
+
+    std::lock_guard< std::mutex > guard (record_mutex);
+
+    const size_t index = size_t (record & 0xffffffff);
+
+    // A record of a previous recording
+    if ((record >> 32) != record_session || index >= records.size ()) {
+        return;
+    }
+
+    records[index].bytes_read += bytes_read;
+}
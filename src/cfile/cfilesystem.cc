@@ -5,6 +5,8 @@
 #include <dirent.h>
 #include <fnmatch.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <libgen.h>
 #include <cstdlib>
@@ -13,16 +15,22 @@
 #include <cerrno>
 #include <sstream>
 #include <algorithm>
+#include <atomic>
+#include <unordered_map>
+#include <vector>
 
 #include "defs.hh"
 #include "cfile/cfile.hh"
+#include "cfile/cfilearchive.hh"
 #include "cfile/cfilesystem.hh"
 #include "cmdline/cmdline.hh"
+#include "io/timer.hh"
 #include "shared/types.hh"
 #include "localization/localize.hh"
 #include "osapi/osapi.hh"
 #include "parse/parselo.hh"
 #include "util/strings.hh"
+#include "util/ThreadPool.hh"
 #include "assert/assert.hh"
 #include "log/log.hh"
 
@@ -90,6 +98,34 @@ typedef struct cf_file_block {
 static uint Num_files = 0;
 static cf_file_block* File_blocks[CF_MAX_FILE_BLOCKS];
 
+// Case insensitive hashing and comparison of file names
+struct cf_name_hash {
+    size_t operator() (const std::string& name) const {
+        size_t hash = 2166136261U;
+
+        for (auto c : name) {
+            hash = (hash ^ size_t (tolower ((unsigned char)c))) * 16777619U;
+        }
+
+        return hash;
+    }
+};
+
+struct cf_name_equal {
+    bool operator() (const std::string& lhs, const std::string& rhs) const {
+        return !strcasecmp (lhs.c_str (), rhs.c_str ());
+    }
+};
+
+typedef std::unordered_map<
+    std::string, std::vector< uint >, cf_name_hash, cf_name_equal >
+    cf_file_index;
+
+// Indices of the files by name and extension, and by name alone; the indices
+// of every name are in increasing order, which is the order of precedence
+static cf_file_index File_index;
+static cf_file_index File_base_index;
+
 // Return a pointer to to file 'index'.
 cf_file* cf_get_file (int index) {
     int block = index / CF_NUM_FILES_PER_BLOCK;
@@ -448,7 +484,9 @@ int is_ext_in_list (const char* ext_list, const char* ext) {
     return 0;
 }
 
-void cf_search_root_path (int root_index) {
+// The root searches run on the worker pool, each adding the files of its root
+// to a list of its own, to be appended to the file list in root order
+void cf_search_root_path (int root_index, std::vector< cf_file >& files) {
     int i;
     int num_files = 0;
 
@@ -562,7 +600,8 @@ void cf_search_root_path (int root_index) {
                     if (ext) {
                         if (is_ext_in_list (Pathtypes[i].extensions, ext)) {
                             // Found a file!!!!
-                            cf_file* file = cf_create_file ();
+                            files.emplace_back ();
+                            cf_file* file = &files.back ();
 
                             strcpy (file->name_ext, dir->d_name);
                             file->root_index = root_index;
@@ -603,19 +642,303 @@ typedef struct VP_FILE {
     _fs_time_t write_time;
 } VP_FILE;
 
-void cf_search_root_pack (int root_index) {
+//
+// The file tables of the pack files are cached between runs in the config
+// directory, keyed by the path, size and modification time of every pack. The
+// cache is a header, the table of the packs and the entries of all the packs,
+// all of fixed size, so that it is mapped and used in place. A pack that
+// changed is read again and the cache is rewritten after the search.
+//
+#define VP_CACHE_FILENAME "vp_index.cache"
+#define VP_CACHE_VERSION 1
+
+typedef struct vp_cache_header {
+    char id[8];
+    uint32_t version;
+    uint32_t pack_size;  // sizes of the records, to catch a change of layout
+    uint32_t entry_size;
+    uint32_t num_packs;
+    uint32_t num_entries;
+    uint32_t pathtypes_hash; // of the table the pathtype indices refer to
+} vp_cache_header;
+
+typedef struct vp_cache_pack {
+    char path[CF_MAX_PATHNAME_LENGTH];
+    int64_t size;
+    int64_t write_time;
+    uint32_t first; // the first entry of the pack
+    uint32_t count;
+} vp_cache_pack;
+
+typedef struct vp_cache_entry {
+    char name_ext[CF_MAX_FILENAME_LENGTH];
+    int32_t pathtype_index;
+    int32_t size;
+    int32_t pack_offset;
+    int32_t reserved;
+    int64_t write_time;
+} vp_cache_entry;
+
+static void* Vp_cache_data = nullptr;
+static size_t Vp_cache_length = 0;
+
+static std::unordered_map< std::string, const vp_cache_pack* > Vp_cache_packs;
+static const vp_cache_entry* Vp_cache_entries = nullptr;
+
+// Set by the pack searches that miss the cache
+static std::atomic< bool > Vp_cache_stale{ false };
+
+static const char vp_cache_id[8] = { 'F', 'S', '2', 'V', 'P', 'I', 'D', 'X' };
+
+// FNV-1a hash of the path types, which decide the pathtype index of every
+// entry and which entries are kept at all
+static uint32_t vp_cache_pathtypes_hash () {
+    uint32_t hash = 2166136261u;
+
+    auto add = [&](const void* data, size_t length) {
+        auto p = (const unsigned char*)data;
+
+        for (size_t i = 0; i < length; ++i) {
+            hash = (hash ^ p[i]) * 16777619u;
+        }
+    };
+
+    for (int i = 0; i < CF_MAX_PATH_TYPES; ++i) {
+        const auto& pathtype = Pathtypes[i];
+
+        // the terminators separate the strings
+        const char* path = pathtype.path ? pathtype.path : "";
+        const char* extensions = pathtype.extensions ? pathtype.extensions : "";
+
+        add (&pathtype.index, sizeof pathtype.index);
+        add (path, strlen (path) + 1);
+        add (extensions, strlen (extensions) + 1);
+        add (&pathtype.parent_index, sizeof pathtype.parent_index);
+    }
+
+    return hash;
+}
+
+static void vp_cache_unload () {
+    if (Vp_cache_data) { munmap (Vp_cache_data, Vp_cache_length); }
+
+    Vp_cache_data = nullptr;
+    Vp_cache_length = 0;
+
+    Vp_cache_packs.clear ();
+    Vp_cache_entries = nullptr;
+}
+
+static void vp_cache_load () {
+    vp_cache_unload ();
+
+    const auto filename = fs2::os::get_config_path (VP_CACHE_FILENAME);
+
+    int fd = open (filename.c_str (), O_RDONLY);
+    if (fd < 0) { return; }
+
+    struct stat buf;
+    if (fstat (fd, &buf) == 0 &&
+        size_t (buf.st_size) > sizeof (vp_cache_header)) {
+        Vp_cache_length = size_t (buf.st_size);
+        Vp_cache_data =
+            mmap (NULL, Vp_cache_length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (Vp_cache_data == MAP_FAILED) {
+            Vp_cache_data = nullptr;
+            Vp_cache_length = 0;
+        }
+    }
+
+    close (fd);
+
+    if (Vp_cache_data == nullptr) { return; }
+
+    auto header = (const vp_cache_header*)Vp_cache_data;
+
+    auto packs = (const vp_cache_pack*)(header + 1);
+    auto entries = (const vp_cache_entry*)(packs + header->num_packs);
+
+    const size_t expected_length =
+        sizeof (vp_cache_header) +
+        size_t (header->num_packs) * sizeof (vp_cache_pack) +
+        size_t (header->num_entries) * sizeof (vp_cache_entry);
+
+    if (memcmp (header->id, vp_cache_id, sizeof vp_cache_id) ||
+        header->version != VP_CACHE_VERSION ||
+        header->pack_size != sizeof (vp_cache_pack) ||
+        header->entry_size != sizeof (vp_cache_entry) ||
+        header->pathtypes_hash != vp_cache_pathtypes_hash () ||
+        expected_length != Vp_cache_length) {
+        WARNINGF (LOCATION, "Ignoring the invalid pack index cache %s",filename.c_str ());
+        vp_cache_unload ();
+        return;
+    }
+
+    for (uint32_t i = 0; i < header->num_packs; ++i) {
+        const auto& pack = packs[i];
+
+        if (pack.path[sizeof pack.path - 1] ||
+            uint64_t (pack.first) + pack.count > header->num_entries) {
+            WARNINGF (LOCATION, "Ignoring the invalid pack index cache %s",filename.c_str ());
+            vp_cache_unload ();
+            return;
+        }
+
+        Vp_cache_packs[pack.path] = &pack;
+    }
+
+    Vp_cache_entries = entries;
+}
+
+// Adds the files of a pack from the cache, if the pack did not change
+static bool vp_cache_search (
+    int root_index, const struct stat& buf, std::vector< cf_file >& files) {
+    cf_root* root = cf_get_root (root_index);
+
+    auto iter = Vp_cache_packs.find (root->path);
+    if (iter == Vp_cache_packs.end ()) { return false; }
+
+    const vp_cache_pack* pack = iter->second;
+
+    if (pack->size != int64_t (buf.st_size) ||
+        pack->write_time != int64_t (buf.st_mtime)) {
+        return false;
+    }
+
+    const vp_cache_entry* entry = Vp_cache_entries + pack->first;
+    files.resize (pack->count);
+
+    for (auto& file : files) {
+        if (entry->pathtype_index < CF_TYPE_ROOT ||
+            entry->pathtype_index >= CF_MAX_PATH_TYPES) {
+            files.clear ();
+            return false;
+        }
+
+        memcpy (file.name_ext, entry->name_ext, sizeof file.name_ext);
+        file.name_ext[sizeof file.name_ext - 1] = '\0';
+
+        file.root_index = root_index;
+        file.pathtype_index = entry->pathtype_index;
+        file.write_time = (time_t)entry->write_time;
+        file.size = entry->size;
+        file.pack_offset = entry->pack_offset;
+
+        ++entry;
+    }
+
+    return true;
+}
+
+// Writes the file tables of the packs of the current roots
+static void vp_cache_save (const std::vector< std::vector< cf_file > >& files) {
+    std::vector< vp_cache_pack > packs;
+    std::vector< vp_cache_entry > entries;
+
+    for (int i = 0; i < Num_roots; i++) {
+        cf_root* root = cf_get_root (i);
+
+        if (root->roottype != CF_ROOTTYPE_PACK) continue;
+
+        struct stat buf;
+        if (stat (root->path, &buf) == -1) continue;
+
+        vp_cache_pack pack;
+        memset (&pack, 0, sizeof pack);
+
+        strncpy (pack.path, root->path, sizeof pack.path - 1);
+        pack.size = buf.st_size;
+        pack.write_time = buf.st_mtime;
+        pack.first = uint32_t (entries.size ());
+        pack.count = uint32_t (files[i].size ());
+
+        packs.push_back (pack);
+
+        for (const auto& file : files[i]) {
+            vp_cache_entry entry;
+            memset (&entry, 0, sizeof entry);
+
+            memcpy (entry.name_ext, file.name_ext, sizeof entry.name_ext);
+            entry.pathtype_index = file.pathtype_index;
+            entry.size = file.size;
+            entry.pack_offset = file.pack_offset;
+            entry.write_time = int64_t (file.write_time);
+
+            entries.push_back (entry);
+        }
+    }
+
+    vp_cache_header header;
+    memset (&header, 0, sizeof header);
+
+    memcpy (header.id, vp_cache_id, sizeof header.id);
+    header.version = VP_CACHE_VERSION;
+    header.pack_size = sizeof (vp_cache_pack);
+    header.entry_size = sizeof (vp_cache_entry);
+    header.num_packs = uint32_t (packs.size ());
+    header.num_entries = uint32_t (entries.size ());
+    header.pathtypes_hash = vp_cache_pathtypes_hash ();
+
+    // Written aside and renamed, so that a partial cache is never read
+    const auto filename = fs2::os::get_config_path (VP_CACHE_FILENAME);
+    const auto tmp_filename = filename.string () + ".tmp";
+
+    FILE* fp = fopen (tmp_filename.c_str (), "wb");
+
+    if (fp == NULL) {
+        WARNINGF (LOCATION, "Cannot write the pack index cache %s",tmp_filename.c_str ());
+        return;
+    }
+
+    bool good = fwrite (&header, sizeof header, 1, fp) == 1;
+
+    good = good && fwrite (
+                       packs.data (), sizeof (vp_cache_pack), packs.size (),
+                       fp) == packs.size ();
+
+    good = good && fwrite (
+                       entries.data (), sizeof (vp_cache_entry),
+                       entries.size (), fp) == entries.size ();
+
+    good = (fclose (fp) == 0) && good;
+
+    if (!good || rename (tmp_filename.c_str (), filename.c_str ()) == -1) {
+        WARNINGF (LOCATION, "Cannot write the pack index cache %s",filename.c_str ());
+        unlink (tmp_filename.c_str ());
+        return;
+    }
+
+    II << "wrote the index of " << packs.size () << " packs to "
+       << filename.string ();
+}
+
+void cf_search_root_pack (int root_index, std::vector< cf_file >& files) {
     int num_files = 0;
     cf_root* root = cf_get_root (root_index);
 
     ASSERT (root != NULL);
 
+    {
+        struct stat buf;
+
+        if (stat (root->path, &buf) == 0 &&
+            vp_cache_search (root_index, buf, files)) {
+            WARNINGF (LOCATION, "Searching root pack '%s' ... %i cached files", root->path, int (files.size ()));
+            return;
+        }
+    }
+
+    Vp_cache_stale = true;
+
     // Open data
     FILE* fp = fopen (root->path, "rb");
     // Read the file header
     if (!fp) { return; }
 
-    if (cfilelength (fileno (fp)) <
-        (int)(sizeof (VP_FILE_HEADER) + (sizeof (int) * 3))) {
+    const int length = cfilelength (fileno (fp));
+
+    if (length < (int)(sizeof (VP_FILE_HEADER) + (sizeof (int) * 3))) {
         WARNINGF (LOCATION, "Skipping VP file ('%s') of invalid size...",root->path);
         fclose (fp);
         return;
@@ -632,22 +955,34 @@ void cf_search_root_pack (int root_index) {
 
     WARNINGF (LOCATION, "Searching root pack '%s' ... ", root->path);
 
-    // Read index info
+    // Read the whole index at once, as much of it as the file holds
+    size_t num_entries = 0;
+
+    if (VP_header.index_offset >= 0 && VP_header.index_offset < length &&
+        VP_header.num_files > 0) {
+        num_entries = (std::min) (
+            size_t (VP_header.num_files),
+            size_t (length - VP_header.index_offset) / sizeof (VP_FILE));
+    }
+
+    std::vector< VP_FILE > entries (num_entries);
+
     fseek (fp, VP_header.index_offset, SEEK_SET);
+    num_entries = fread (entries.data (), sizeof (VP_FILE), num_entries, fp);
+
+    fclose (fp);
+
+    if (num_entries < size_t ((std::max) (VP_header.num_files, 0))) {
+        WARNINGF (LOCATION,"Failed to read file entries of %s, read %d of %d!",root->path,int (num_entries),VP_header.num_files);
+    }
 
     char search_path[CF_MAX_PATHNAME_LENGTH];
 
     strcpy (search_path, "");
 
     // Go through all the files
-    int i;
-    for (i = 0; i < VP_header.num_files; i++) {
-        VP_FILE find;
-
-        if (fread (&find, sizeof (VP_FILE), 1, fp) != 1) {
-            WARNINGF (LOCATION,"Failed to read file entry (currently in directory %s)!",search_path);
-            break;
-        }
+    for (size_t i = 0; i < num_entries; i++) {
+        VP_FILE& find = entries[i];
 
         find.filename[sizeof (find.filename) - 1] = '\0';
 
@@ -679,7 +1014,8 @@ void cf_search_root_pack (int root_index) {
                     if (ext) {
                         if (is_ext_in_list (Pathtypes[j].extensions, ext)) {
                             // Found a file!!!!
-                            cf_file* file = cf_create_file ();
+                            files.emplace_back ();
+                            cf_file* file = &files.back ();
                             strcpy (file->name_ext, find.filename);
                             file->root_index = root_index;
                             file->pathtype_index = j;
@@ -698,29 +1034,80 @@ void cf_search_root_pack (int root_index) {
         }
     }
 
-    fclose (fp);
-
     WARNINGF (LOCATION, "%i files", num_files);
 }
 
-void cf_search_memory_root (int) {}
+void cf_search_memory_root (int, std::vector< cf_file >&) {}
+
+static void cf_build_file_index () {
+    File_index.clear ();
+    File_base_index.clear ();
+
+    File_index.reserve (Num_files);
+    File_base_index.reserve (Num_files);
+
+    for (uint ui = 0; ui < Num_files; ui++) {
+        const cf_file* f = cf_get_file (ui);
+
+        File_index[f->name_ext].push_back (ui);
+
+        const char* ext = strrchr (f->name_ext, '.');
+        const size_t len = ext ? size_t (ext - f->name_ext)
+                               : strlen (f->name_ext);
+
+        File_base_index[std::string (f->name_ext, len)].push_back (ui);
+    }
+}
+
+// The indices of the files of the given name, in the order of precedence
+static const std::vector< uint >&
+cf_find_in_index (const cf_file_index& index, const char* name) {
+    static const std::vector< uint > none;
+
+    auto iter = index.find (name);
+    return iter == index.end () ? none : iter->second;
+}
 
 void cf_build_file_list () {
     int i;
 
     Num_files = 0;
 
+    std::vector< std::vector< cf_file > > root_files (Num_roots);
+
+    vp_cache_load ();
+    Vp_cache_stale = false;
+
     // For each root, find all files...
+    util::worker_pool ().parallel_for (
+        Num_roots, 1, [&](size_t first, size_t last) {
+            for (size_t n = first; n < last; ++n) {
+                cf_root* root = cf_get_root (int (n));
+                auto& files = root_files[n];
+
+                if (root->roottype == CF_ROOTTYPE_PATH) {
+                    cf_search_root_path (int (n), files);
+                }
+                else if (root->roottype == CF_ROOTTYPE_PACK) {
+                    cf_search_root_pack (int (n), files);
+                }
+                else if (root->roottype == CF_ROOTTYPE_MEMORY) {
+                    cf_search_memory_root (int (n), files);
+                }
+            }
+        });
+
+    // ... and list them in the order of the roots, which is their precedence
     for (i = 0; i < Num_roots; i++) {
-        cf_root* root = cf_get_root (i);
-        if (root->roottype == CF_ROOTTYPE_PATH) { cf_search_root_path (i); }
-        else if (root->roottype == CF_ROOTTYPE_PACK) {
-            cf_search_root_pack (i);
-        }
-        else if (root->roottype == CF_ROOTTYPE_MEMORY) {
-            cf_search_memory_root (i);
-        }
+        for (auto& file : root_files[i]) { *cf_create_file () = file; }
     }
+
+    // The cache is rewritten with the packs of these roots alone
+    if (Vp_cache_stale) { vp_cache_save (root_files); }
+
+    vp_cache_unload ();
+
+    cf_build_file_index ();
 }
 
 void cf_build_secondary_filelist (const char* cdrom_dir) {
@@ -775,6 +1162,9 @@ void cf_free_secondary_filelist () {
         }
     }
     Num_files = 0;
+
+    File_index.clear ();
+    File_base_index.clear ();
 }
 
 /**
@@ -789,7 +1179,7 @@ void cf_free_secondary_filelist () {
  *
  * @return A structure which describes the found file
  */
-CFileLocation cf_find_file_location (
+static CFileLocation cf_find_file_location_sub (
     const char* filespec, int pathtype, bool localize,
     uint32_t location_flags) {
     int i;
@@ -876,93 +1266,104 @@ CFileLocation cf_find_file_location (
         }
     }
 
-    // Search the pak files and CD-ROM.
-    for (ui = 0; ui < Num_files; ui++) {
-        cf_file* f = cf_get_file (ui);
+    // Search the pak files and CD-ROM. The file of the lowest index wins,
+    // whether found by its localized name or by its plain one.
+    const std::vector< uint >* names[2] = { nullptr, nullptr };
 
-        // only search paths we're supposed to...
-        if ((pathtype != CF_TYPE_ANY) && (pathtype != f->pathtype_index))
-            continue;
-
-        if (location_flags != CF_LOCATION_ALL) {
-            // If a location flag was specified we need to check if the root of
-            // this file satisfies the request
-            auto root = cf_get_root (f->root_index);
+    if (localize) {
+        // create localized filespec
+        strncpy (longname, filespec, MAX_PATH_LEN - 1);
 
-            if (!cf_check_location_flags (
-                    root->location_flags, location_flags)) {
-                // Root does not satisfy location flags
-                continue;
-            }
+        if (lcl_add_dir_to_path_with_filename (longname, MAX_PATH_LEN - 1)) {
+            names[0] = &cf_find_in_index (File_index, longname);
         }
+    }
 
-        if (localize) {
-            // create localized filespec
-            strncpy (longname, filespec, MAX_PATH_LEN - 1);
+    names[1] = &cf_find_in_index (File_index, filespec);
 
-            if (lcl_add_dir_to_path_with_filename (
-                    longname, MAX_PATH_LEN - 1)) {
-                if (!strcasecmp (longname, f->name_ext)) {
-                    CFileLocation res (true);
-                    res.size = static_cast< size_t > (f->size);
-                    res.offset = (size_t)f->pack_offset;
-                    res.data_ptr = f->data;
-
-                    if (f->data != nullptr) {
-                        // This is an in-memory file so we just copy the
-                        // pathtype name + file name
-                        res.full_name = Pathtypes[f->pathtype_index].path;
-                        res.full_name += "/";
-                        res.full_name += f->name_ext;
-                    }
-                    else if (f->pack_offset < 1) {
-                        // This is a real file, return the actual file path
-                        res.full_name = f->real_name;
-                    }
-                    else {
-                        // File is in a pack file
-                        cf_root* r = cf_get_root (f->root_index);
+    cf_file* found = nullptr;
+    uint found_index = Num_files;
 
-                        res.full_name = r->path;
-                    }
+    for (auto indices : names) {
+        if (indices == nullptr) continue;
 
-                    return res;
+        for (auto index : *indices) {
+            if (index >= found_index) break;
+
+            cf_file* f = cf_get_file (index);
+
+            // only search paths we're supposed to...
+            if ((pathtype != CF_TYPE_ANY) && (pathtype != f->pathtype_index))
+                continue;
+
+            if (location_flags != CF_LOCATION_ALL) {
+                // If a location flag was specified we need to check if the
+                // root of this file satisfies the request
+                auto root = cf_get_root (f->root_index);
+
+                if (!cf_check_location_flags (
+                        root->location_flags, location_flags)) {
+                    // Root does not satisfy location flags
+                    continue;
                 }
             }
+
+            found = f;
+            found_index = index;
+            break;
         }
+    }
 
-        // file either not localized or localized version not found
-        if (!strcasecmp (filespec, f->name_ext)) {
-            CFileLocation res (true);
-            res.size = static_cast< size_t > (f->size);
-            res.offset = (size_t)f->pack_offset;
-            res.data_ptr = f->data;
-
-            if (f->data != nullptr) {
-                // This is an in-memory file so we just copy the pathtype name
-                // + file name
-                res.full_name = Pathtypes[f->pathtype_index].path;
-                res.full_name += "/";
-                res.full_name += f->name_ext;
-            }
-            else if (f->pack_offset < 1) {
-                // This is a real file, return the actual file path
-                res.full_name = f->real_name;
-            }
-            else {
-                // File is in a pack file
-                cf_root* r = cf_get_root (f->root_index);
+    if (found) {
+        cf_file* f = found;
 
-                res.full_name = r->path;
-            }
+        CFileLocation res (true);
+        res.size = static_cast< size_t > (f->size);
+        res.offset = (size_t)f->pack_offset;
+        res.data_ptr = f->data;
 
-            return res;
+        if (f->data != nullptr) {
+            // This is an in-memory file so we just copy the pathtype name
+            // + file name
+            res.full_name = Pathtypes[f->pathtype_index].path;
+            res.full_name += "/";
+            res.full_name += f->name_ext;
+        }
+        else if (f->pack_offset < 1) {
+            // This is a real file, return the actual file path
+            res.full_name = f->real_name;
+        }
+        else {
+            // File is in a pack file
+            cf_root* r = cf_get_root (f->root_index);
+
+            res.full_name = r->path;
         }
+
+        return res;
     }
 
     return CFileLocation ();
 }
 
+CFileLocation cf_find_file_location (
+    const char* filespec, int pathtype, bool localize,
+    uint32_t location_flags) {
+    if (!Cfile_recording) {
+        return cf_find_file_location_sub (
+            filespec, pathtype, localize, location_flags);
+    }
+
+    // The asset recorder times the lookup as part of the open that follows
+    const auto start = timer_get_nanoseconds ();
+
+    auto res = cf_find_file_location_sub (
+        filespec, pathtype, localize, location_flags);
+    if (res.found) { cf_record_lookup (filespec, res, start); }
+
+    return res;
+}
+
 // -- from parselo.cpp --
 extern char* stristr (char* str, const char* substr);
 
@@ -984,7 +1385,7 @@ extern char* stristr (char* str, const char* substr);
  *
  * @return A structure containing information about the found file
  */
-CFileLocationExt cf_find_file_location_ext (
+static CFileLocationExt cf_find_file_location_ext_sub (
     const char* filename, const int ext_num, const char** ext_list,
     int pathtype, bool localize) {
     int cur_ext, i;
@@ -1101,9 +1502,9 @@ CFileLocationExt cf_find_file_location_ext (
 
     file_list_index.reserve (MIN (ext_num * 4, (int)Num_files));
 
-    // next, run though and pick out base matches
-    for (ui = 0; ui < Num_files; ui++) {
-        cf_file* f = cf_get_file (ui);
+    // next, run though the files of our base name and pick out base matches
+    for (auto index : cf_find_in_index (File_base_index, filespec)) {
+        cf_file* f = cf_get_file (index);
 
         // ... only search paths that we're supposed to
         if ((num_search_dirs == 1) && (pathtype != f->pathtype_index))
@@ -1232,6 +1633,35 @@ CFileLocationExt cf_find_file_location_ext (
     return CFileLocationExt ();
 }
 
+CFileLocationExt cf_find_file_location_ext (
+    const char* filename, const int ext_num, const char** ext_list,
+    int pathtype, bool localize) {
+    if (!Cfile_recording) {
+        return cf_find_file_location_ext_sub (
+            filename, ext_num, ext_list, pathtype, localize);
+    }
+
+    const auto start = timer_get_nanoseconds ();
+
+    auto res = cf_find_file_location_ext_sub (
+        filename, ext_num, ext_list, pathtype, localize);
+
+    if (res.found) {
+        // The name with the extension found, stripped as the search does
+        std::string name (filename);
+
+        const auto dot = name.rfind ('.');
+        if (dot != std::string::npos && name.size () - dot > 2) {
+            name.erase (dot);
+        }
+
+        name += ext_list[res.extension_index];
+        cf_record_lookup (name.c_str (), res, start);
+    }
+
+    return res;
+}
+
 // Returns true if filename matches filespec, else zero if not
 int cf_matches_spec (const char* filespec, const char* filename) {
     const char* src_ext;
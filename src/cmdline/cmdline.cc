@@ -233,6 +233,24 @@ Flag exe_params[] = {
         "http://www.hard-light.net/wiki/index.php/"
         "Command-Line_Reference#-no_vsync",
     },
+    {
+        "-threads",
+        "Number of simulation worker threads",
+        true,
+        0,
+        EASY_DEFAULT,
+        "Game Speed",
+        "",
+    },
+    {
+        "-parallel_physics",
+        "Integrate physics on worker threads",
+        true,
+        0,
+        EASY_DEFAULT,
+        "Game Speed",
+        "",
+    },
 
     {
         "-dualscanlines",
@@ -776,6 +794,60 @@ Flag exe_params[] = {
         "http://www.hard-light.net/wiki/index.php/"
         "Command-Line_Reference#-profile_write_file",
     },
+    {
+        "-flight_recorder",
+        "Dump recent trace events on a spike",
+        true,
+        0,
+        EASY_DEFAULT,
+        "Dev Tool",
+        "",
+    },
+    {
+        "-frame_stats",
+        "Report frame time percentiles",
+        true,
+        0,
+        EASY_DEFAULT,
+        "Dev Tool",
+        "",
+    },
+    {
+        "-profile_allocs",
+        "Count heap allocations per category",
+        true,
+        0,
+        EASY_DEFAULT,
+        "Dev Tool",
+        "",
+    },
+    {
+        "-asset_manifest",
+        "Write the files each mission loads",
+        true,
+        0,
+        EASY_DEFAULT,
+        "Dev Tool",
+        "",
+    },
+    {
+        "-profile_samples",
+        "Sample call stacks to a flame graph",
+        true,
+        0,
+        EASY_DEFAULT,
+        "Dev Tool",
+        "",
+    },
+    {
+        "-profile_trace",
+        "Write every trace event to a file",
+        true,
+        0,
+        EASY_DEFAULT,
+        "Dev Tool",
+        "",
+    },
     {
         "-no_unfocused_pause",
         "Don't pause if the window isn't focused",
@@ -796,6 +868,15 @@ Flag exe_params[] = {
         "http://www.hard-light.net/wiki/index.php/"
         "Command-Line_Reference#-benchmark_mode",
     },
+    {
+        "-headless_benchmark",
+        "Run a mission headless and time it",
+        true,
+        0,
+        EASY_DEFAULT,
+        "Dev Tool",
+        "",
+    },
     {
         "-noninteractive",
         "Disables interactive dialogs",
@@ -965,9 +1046,17 @@ cmdline_parm no_fpscap (
     "-no_fps_capping", "Don't limit frames-per-second",
     AT_NONE);                                           // Cmdline_NoFPSCap
 cmdline_parm no_vsync_arg ("-no_vsync", NULL, AT_NONE); // Cmdline_no_vsync
+cmdline_parm threads_arg (
+    "-threads", "Number of simulation worker threads (0 to disable)",
+    AT_INT); // Cmdline_threads
+cmdline_parm parallel_physics_arg (
+    "-parallel_physics", "Integrate object physics on the worker threads",
+    AT_NONE); // Cmdline_parallel_physics
 
 int Cmdline_NoFPSCap = 0; // Disable FPS capping - kazan
 int Cmdline_no_vsync = 0;
+int Cmdline_threads = -1; // one less than the number of cores
+int Cmdline_parallel_physics = 0;
 
 // HUD related
 cmdline_parm ballistic_gauge (
@@ -1127,6 +1216,34 @@ cmdline_parm reparse_mainhall_arg (
     "-reparse_mainhall", NULL, AT_NONE); // Cmdline_reparse_mainhall
 cmdline_parm frame_profile_write_file (
     "-profile_write_file", NULL, AT_NONE); // Cmdline_profile_write_file
+cmdline_parm frame_stats_arg (
+    "-frame_stats", "Report frame time percentiles at mission end",
+    AT_NONE); // Cmdline_frame_stats
+cmdline_parm frame_budget_arg (
+    "-frame_budget",
+    "Frame time budget for -frame_stats and -flight_recorder, in ms",
+    AT_FLOAT); // Cmdline_frame_budget
+cmdline_parm flight_recorder_arg (
+    "-flight_recorder", "Dump the last trace events to files of this prefix",
+    AT_STRING); // Cmdline_flight_recorder
+cmdline_parm flight_window_arg (
+    "-flight_window", "Seconds of trace events kept by -flight_recorder",
+    AT_FLOAT); // Cmdline_flight_window
+cmdline_parm profile_allocations_arg (
+    "-profile_allocs", "Count the heap allocations of every category",
+    AT_NONE); // Cmdline_profile_allocations
+cmdline_parm asset_manifest_arg (
+    "-asset_manifest", "Write the files loaded by each mission, by this prefix",
+    AT_STRING); // Cmdline_asset_manifest
+cmdline_parm profile_samples_arg (
+    "-profile_samples", "Write sampled call stacks, folded, to this file",
+    AT_STRING); // Cmdline_profile_samples
+cmdline_parm profile_sample_rate_arg (
+    "-profile_sample_hz", "Call stack samples per second of CPU time",
+    AT_INT); // Cmdline_profile_sample_rate
+cmdline_parm profile_trace_arg (
+    "-profile_trace", "Write every trace event to this binary file",
+    AT_STRING); // Cmdline_profile_trace
 cmdline_parm benchmark_mode_arg (
     "-benchmark_mode", NULL, AT_NONE); // Cmdline_benchmark_mode
 cmdline_parm noninteractive_arg (
@@ -1135,6 +1252,24 @@ cmdline_parm show_video_info (
     "-show_video_info", NULL, AT_NONE); // Cmdline_show_video_info
 cmdline_parm frame_profile_arg (
     "-profile_frame_time", NULL, AT_NONE); // Cmdline_frame_profile
+cmdline_parm headless_benchmark_arg (
+    "-headless_benchmark", "Run this mission headless for a fixed frame count",
+    AT_STRING); // Cmdline_headless_benchmark
+cmdline_parm benchmark_frames_arg (
+    "-benchmark_frames", "Frames to run with -headless_benchmark",
+    AT_INT); // Cmdline_benchmark_frames
+cmdline_parm benchmark_frametime_arg (
+    "-benchmark_frametime", "Seconds per frame with -headless_benchmark",
+    AT_FLOAT); // Cmdline_benchmark_frametime
+cmdline_parm benchmark_input_arg (
+    "-benchmark_input", "Replay the player controls recorded in this file",
+    AT_STRING); // Cmdline_benchmark_input
+cmdline_parm benchmark_output_arg (
+    "-benchmark_output", "Write the timings here, .csv or .json",
+    AT_STRING); // Cmdline_benchmark_output
+cmdline_parm record_input_arg (
+    "-record_input", "Record the player controls to this file",
+    AT_STRING); // Cmdline_record_input
 
 char* Cmdline_start_mission = NULL;
 int Cmdline_old_collision_sys = 0;
@@ -1157,10 +1292,25 @@ char* Cmdline_center_res = 0;
 int Cmdline_verify_vps = 0;
 int Cmdline_reparse_mainhall = 0;
 bool Cmdline_profile_write_file = false;
+char* Cmdline_profile_trace = NULL;
+char* Cmdline_profile_samples = NULL;
+bool Cmdline_profile_allocations = false;
+int Cmdline_profile_sample_rate = 1000;
+bool Cmdline_frame_stats = false;
+float Cmdline_frame_budget = 1000.0f / 60.0f;
+char* Cmdline_flight_recorder = NULL;
+float Cmdline_flight_window = 5.0f;
+char* Cmdline_asset_manifest = NULL;
 bool Cmdline_benchmark_mode = false;
 bool Cmdline_noninteractive = false;
 bool Cmdline_frame_profile = false;
 bool Cmdline_show_video_info = false;
+char* Cmdline_headless_benchmark = NULL;
+int Cmdline_benchmark_frames = 3600;
+float Cmdline_benchmark_frametime = 1.0f / 60.0f;
+char* Cmdline_benchmark_input = NULL;
+char* Cmdline_benchmark_output = NULL;
+char* Cmdline_record_input = NULL;
 
 // Other
 cmdline_parm output_sexp_arg (
@@ -1938,6 +2088,14 @@ bool SetCmdlineParams () {
 
     if (no_vsync_arg.found ()) { Cmdline_no_vsync = 1; }
 
+    if (threads_arg.found ()) {
+        Cmdline_threads = threads_arg.get_int ();
+
+        CLAMP (Cmdline_threads, 0, 64);
+    }
+
+    if (parallel_physics_arg.found ()) { Cmdline_parallel_physics = 1; }
+
     if (normal_arg.found ()) { Cmdline_normal = 0; }
 
     if (height_arg.found ()) { Cmdline_height = 0; }
@@ -2053,6 +2211,42 @@ bool SetCmdlineParams () {
         Cmdline_profile_write_file = true;
     }
 
+    if (frame_stats_arg.found ()) { Cmdline_frame_stats = true; }
+
+    if (frame_budget_arg.found ()) {
+        Cmdline_frame_budget = (std::max) (0.f, frame_budget_arg.get_float ());
+    }
+
+    if (flight_recorder_arg.found ()) {
+        Cmdline_flight_recorder = flight_recorder_arg.str ();
+    }
+
+    if (flight_window_arg.found ()) {
+        Cmdline_flight_window =
+            (std::max) (0.1f, flight_window_arg.get_float ());
+    }
+
+    if (profile_allocations_arg.found ()) {
+        Cmdline_profile_allocations = true;
+    }
+
+    if (asset_manifest_arg.found ()) {
+        Cmdline_asset_manifest = asset_manifest_arg.str ();
+    }
+
+    if (profile_samples_arg.found ()) {
+        Cmdline_profile_samples = profile_samples_arg.str ();
+    }
+
+    if (profile_sample_rate_arg.found ()) {
+        Cmdline_profile_sample_rate =
+            (std::max) (1, profile_sample_rate_arg.get_int ());
+    }
+
+    if (profile_trace_arg.found ()) {
+        Cmdline_profile_trace = profile_trace_arg.str ();
+    }
+
     if (benchmark_mode_arg.found ()) { Cmdline_benchmark_mode = true; }
 
     if (noninteractive_arg.found ()) { Cmdline_noninteractive = true; }
@@ -2061,6 +2255,39 @@ bool SetCmdlineParams () {
 
     if (show_video_info.found ()) { Cmdline_show_video_info = true; }
 
+    if (headless_benchmark_arg.found ()) {
+        Cmdline_headless_benchmark = headless_benchmark_arg.str ();
+
+        // no window, no sound and no waiting for the clock
+        Cmdline_freespace_no_sound = 1;
+        Cmdline_freespace_no_music = 1;
+        Cmdline_NoFPSCap = 1;
+    }
+
+    if (benchmark_frames_arg.found ()) {
+        Cmdline_benchmark_frames = benchmark_frames_arg.get_int ();
+
+        if (Cmdline_benchmark_frames < 1) { Cmdline_benchmark_frames = 1; }
+    }
+
+    if (benchmark_frametime_arg.found ()) {
+        Cmdline_benchmark_frametime = benchmark_frametime_arg.get_float ();
+
+        CLAMP (Cmdline_benchmark_frametime, 0.001f, 0.25f);
+    }
+
+    if (benchmark_input_arg.found ()) {
+        Cmdline_benchmark_input = benchmark_input_arg.str ();
+    }
+
+    if (benchmark_output_arg.found ()) {
+        Cmdline_benchmark_output = benchmark_output_arg.str ();
+    }
+
+    if (record_input_arg.found ()) {
+        Cmdline_record_input = record_input_arg.str ();
+    }
+
     // Deprecated flags - CommanderDJ
     if (deprecated_spec_arg.found ()) { Cmdline_deprecated_spec = 1; }
 
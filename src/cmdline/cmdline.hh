@@ -75,6 +75,8 @@ extern int Cmdline_aniso_level;
 // Game Speed related
 extern int Cmdline_NoFPSCap;
 extern int Cmdline_no_vsync;
+extern int Cmdline_threads;
+extern int Cmdline_parallel_physics;
 
 // HUD related
 extern int Cmdline_ballistic_gauge;
@@ -135,9 +137,24 @@ extern int Cmdline_save_render_targets;
 extern int Cmdline_verify_vps;
 extern int Cmdline_reparse_mainhall;
 extern bool Cmdline_profile_write_file;
+extern char* Cmdline_profile_trace;
+extern char* Cmdline_profile_samples;
+extern bool Cmdline_profile_allocations;
+extern int Cmdline_profile_sample_rate;
+extern bool Cmdline_frame_stats;
+extern float Cmdline_frame_budget;
+extern char* Cmdline_flight_recorder;
+extern float Cmdline_flight_window;
+extern char* Cmdline_asset_manifest;
 extern bool Cmdline_benchmark_mode;
 extern bool Cmdline_noninteractive;
 extern bool Cmdline_frame_profile;
 extern bool Cmdline_show_video_info;
+extern char* Cmdline_headless_benchmark;
+extern int Cmdline_benchmark_frames;
+extern float Cmdline_benchmark_frametime;
+extern char* Cmdline_benchmark_input;
+extern char* Cmdline_benchmark_output;
+extern char* Cmdline_record_input;
 
 #endif // FREESPACE2_CMDLINE_CMDLINE_HH
@@ -5,6 +5,7 @@
 #include <SDL.h>
 #include <SDL_main.h>
 #include <cinttypes>
+#include <fstream>
 #include <stdexcept>
 
 #include "defs.hh"
@@ -126,6 +127,8 @@
 #include "starfield/supernova.hh"
 #include "stats/medals.hh"
 #include "stats/stats.hh"
+#include "tracing/AllocationTracker.hh"
+#include "tracing/MemoryAccount.hh"
 #include "tracing/Monitor.hh"
 #include "tracing/tracing.hh"
 #include "weapon/beam.hh"
@@ -959,6 +962,17 @@ void game_level_init () {
  * Called when a mission is over -- does server specific stuff.
  */
 void freespace_stop_mission () {
+    player_controls_record_close ();
+
+    if (Cmdline_frame_stats) {
+        II << "frame statistics of " << Game_current_mission_filename << ":\n"
+           << tracing::get_frame_statistics_summary ();
+        tracing::reset_frame_statistics ();
+    }
+
+    II << "memory of " << Game_current_mission_filename << ":\n"
+       << tracing::get_memory_report ();
+
     game_level_close ();
     Game_mode &= ~GM_IN_MISSION;
 }
@@ -1255,6 +1269,20 @@ void game_post_level_init () {
     freespace_mission_load_stuff ();
 }
 
+/**
+ * Writes the files opened since the start of the level load to the manifest
+ * of the mission, named after the -asset_manifest prefix and the mission
+ */
+static void game_write_asset_manifest () {
+    std::string filename (Cmdline_asset_manifest);
+
+    filename += '.';
+    filename += Game_current_mission_filename;
+    filename += ".json";
+
+    cf_record_stop (filename.c_str (), Game_current_mission_filename);
+}
+
 /**
  * Tells the server to load the mission and initialize structures
  */
@@ -1263,6 +1291,12 @@ int game_start_mission () {
 
     int s1 = timer_get_milliseconds ();
 
+    // the mission peaks include the memory taken by the level load
+    tracing::memory_start_mission ();
+
+    // record the files the level load opens
+    if (Cmdline_asset_manifest) { cf_record_start (); }
+
     // clear post processing settings
     gr_post_process_set_defaults ();
 
@@ -1283,6 +1317,8 @@ int game_start_mission () {
         game_loading_callback_close ();
         game_level_close ();
 
+        if (Cmdline_asset_manifest) { game_write_asset_manifest (); }
+
         return 0;
     }
 
@@ -1309,6 +1345,11 @@ int game_start_mission () {
     int e1 = timer_get_milliseconds ();
 
     WARNINGF (LOCATION, "Level load took %f seconds.", (e1 - s1) / 1000.0f);
+
+    if (Cmdline_record_input) { player_controls_record (Cmdline_record_input); }
+
+    if (Cmdline_asset_manifest) { game_write_asset_manifest (); }
+
     return 1;
 }
 
@@ -1601,7 +1642,14 @@ void game_init () {
 
     auto sdlGraphicsOperations = std::make_unique< SDLGraphicsOperations > ();
 
-    if (gr_init (std::move (sdlGraphicsOperations)) == false) {
+    // the headless benchmark runs the simulation without a window
+#if FS2_MICROBENCHMARK
+    const int gr_mode = GR_STUB;
+#else
+    const int gr_mode = Cmdline_headless_benchmark ? GR_STUB : GR_DEFAULT;
+#endif // FS2_MICROBENCHMARK
+
+    if (gr_init (std::move (sdlGraphicsOperations), gr_mode) == false) {
         EE << "error intializing graphics!";
         exit (1);
     }
@@ -3731,6 +3779,10 @@ void game_frame (bool paused) {
     // process lightning (nebula only)
     nebl_process ();
 
+    if (Cmdline_profile_allocations) { tracing::allocations::process_frame (); }
+
+    tracing::memory_process_frame ();
+
     if (Cmdline_frame_profile) { tracing::frame_profile_process_frame (); }
 
     DEBUG_GET_TIME (total_time2)
@@ -3854,6 +3906,53 @@ void set_time_compression (float multiplier, float change_time) {
         f2fl (Desired_time_compression - Game_time_compression) / change_time);
 }
 
+/**
+ * Takes the real time of the frame in Frametime, applies the time compression
+ * to it and advances the game clocks by the result
+ */
+static void game_advance_frametime () {
+    flRealframetime = f2fl (Frametime);
+
+    // Handle changes in time compression
+    if (Game_time_compression != Desired_time_compression) {
+        bool ascending = Desired_time_compression > Game_time_compression;
+        if (Time_compression_change_rate)
+            Game_time_compression +=
+                fixmul (Time_compression_change_rate, Frametime);
+        if ((ascending && Game_time_compression > Desired_time_compression) ||
+            (!ascending && Game_time_compression < Desired_time_compression))
+            Game_time_compression = Desired_time_compression;
+    }
+
+    Frametime = fixmul (Frametime, Game_time_compression);
+
+    if (Frametime <= 0) {
+        // If the Frametime is zero or below due to Game_time_compression, set
+        // the Frametime to 1 (1/65536 of a second).
+        Frametime = 1;
+    }
+
+    Last_frame_timestamp = timestamp ();
+
+    flFrametime = f2fl (Frametime);
+
+    timestamp_inc (Frametime);
+
+    // wrap overall frametime if needed
+    if (FrametimeOverall > (INT_MAX - F1_0)) FrametimeOverall = 0;
+
+    FrametimeOverall += Frametime;
+}
+
+/**
+ * Sets the frametime to a fixed value instead of the time taken by the last
+ * frame, for the headless benchmark
+ */
+static void game_set_fixed_frametime (fix frametime) {
+    Frametime = frametime;
+    game_advance_frametime ();
+}
+
 void game_set_frametime (int state) {
     fix thistime = timer_get_fixed_seconds ();
 
@@ -3917,39 +4016,10 @@ void game_set_frametime (int state) {
         Frametime = MAX_FRAMETIME;
     }
 
-    flRealframetime = f2fl (Frametime);
-
-    // Handle changes in time compression
-    if (Game_time_compression != Desired_time_compression) {
-        bool ascending = Desired_time_compression > Game_time_compression;
-        if (Time_compression_change_rate)
-            Game_time_compression +=
-                fixmul (Time_compression_change_rate, Frametime);
-        if ((ascending && Game_time_compression > Desired_time_compression) ||
-            (!ascending && Game_time_compression < Desired_time_compression))
-            Game_time_compression = Desired_time_compression;
-    }
-
-    Frametime = fixmul (Frametime, Game_time_compression);
-
-    if (Frametime <= 0) {
-        // If the Frametime is zero or below due to Game_time_compression, set
-        // the Frametime to 1 (1/65536 of a second).
-        Frametime = 1;
-    }
-
     Last_time = thistime;
     // mprintf(("Frame %i, Last_time = %7.3f\n", Framecount, f2fl(Last_time)));
-    Last_frame_timestamp = timestamp ();
 
-    flFrametime = f2fl (Frametime);
-
-    timestamp_inc (Frametime);
-
-    // wrap overall frametime if needed
-    if (FrametimeOverall > (INT_MAX - F1_0)) FrametimeOverall = 0;
-
-    FrametimeOverall += Frametime;
+    game_advance_frametime ();
 
     II << "frametime : " << std::hex << Frametime;
 }
@@ -5351,6 +5421,169 @@ DCF (pofspew, "Spews POF info without shutting down the game") {
     game_spew_pof_info ();
 }
 
+//
+// Headless benchmark: loads the mission given to -headless_benchmark and runs
+// the simulation half of game_frame for a fixed number of frames with a fixed
+// frametime, without rendering, sound or user input. The player's controls
+// come from a file recorded with -record_input, if one is given, so that two
+// builds can be compared on exactly the same mission run.
+//
+struct benchmark_frame {
+    fix missiontime;
+    std::uint64_t duration; // nanoseconds
+};
+
+static bool game_benchmark_json (const char* filename) {
+    const size_t n = strlen (filename);
+    return n >= 5 && !strcasecmp (filename + n - 5, ".json");
+}
+
+static void game_benchmark_write_csv (
+    const char* filename, const std::vector< benchmark_frame >& frames,
+    const std::vector< tracing::totals::category_total >& totals) {
+    std::ofstream frames_out (filename);
+
+    frames_out << "frame,missiontime,duration_ns\n";
+
+    for (size_t i = 0; i < frames.size (); ++i) {
+        frames_out << i << "," << f2fl (frames[i].missiontime) << ","
+                   << frames[i].duration << "\n";
+    }
+
+    std::ofstream totals_out (std::string (filename) + ".categories.csv");
+
+    totals_out << "category,count,duration_ns\n";
+
+    for (const auto& total : totals) {
+        totals_out << total.category->getName () << "," << total.count << ","
+                   << total.duration << "\n";
+    }
+}
+
+static void game_benchmark_write_json (
+    const char* filename, const std::vector< benchmark_frame >& frames,
+    const std::vector< tracing::totals::category_total >& totals) {
+    std::ofstream out (filename);
+
+    out << "{\n  \"mission\": \"" << Game_current_mission_filename << "\",\n"
+        << "  \"frames\": " << frames.size () << ",\n"
+        << "  \"frametime\": " << Cmdline_benchmark_frametime << ",\n"
+        << "  \"frame_durations_ns\": [";
+
+    for (size_t i = 0; i < frames.size (); ++i) {
+        out << (i ? ", " : "") << frames[i].duration;
+    }
+
+    out << "],\n  \"categories\": [";
+
+    for (size_t i = 0; i < totals.size (); ++i) {
+        out << (i ? "," : "") << "\n    { \"name\": \""
+            << totals[i].category->getName ()
+            << "\", \"count\": " << totals[i].count
+            << ", \"duration_ns\": " << totals[i].duration << " }";
+    }
+
+    out << "\n  ]\n}\n";
+}
+
+static int game_headless_benchmark () {
+    std::string mission = Cmdline_headless_benchmark;
+
+    if (mission.find ('.') == std::string::npos) { mission += ".fs2"; }
+
+    // mission_load failing would bring up a popup nobody can dismiss
+    if (!cf_exists_full (mission.c_str (), CF_TYPE_MISSIONS)) {
+        EE << "benchmark mission " << mission << " not found";
+        return 1;
+    }
+
+    Game_mode = GM_NORMAL;
+    strncpy (
+        Game_current_mission_filename, mission.c_str (), MAX_FILENAME_LEN - 1);
+
+    if (!game_start_mission ()) {
+        EE << "benchmark mission " << mission << " failed to load";
+        return 1;
+    }
+
+    radar_mission_init ();
+    set_current_hud ();
+
+    Game_mode |= GM_IN_MISSION;
+    game_start_time ();
+
+    if (Cmdline_benchmark_input &&
+        !player_controls_replay (Cmdline_benchmark_input)) {
+        EE << "benchmark input " << Cmdline_benchmark_input
+           << " could not be read";
+    }
+
+    const fix frametime = fl2f (Cmdline_benchmark_frametime);
+
+    std::vector< benchmark_frame > frames;
+    frames.reserve (Cmdline_benchmark_frames);
+
+    tracing::totals::enable ();
+    tracing::totals::reset ();
+
+    for (int i = 0; i < Cmdline_benchmark_frames; ++i) {
+        const auto start = timer_get_nanoseconds ();
+
+        game_set_fixed_frametime (frametime);
+        game_update_missiontime ();
+
+        {
+            TRACE_SCOPE (tracing::MainFrame);
+
+            if (Missiontime > Entry_delay_time) { Pre_player_entry = 0; }
+
+            radar_frame_init ();
+            shield_frame_init ();
+
+            if (!Pre_player_entry) {
+                read_player_controls (Player_obj, flFrametime);
+            }
+
+            game_whack_reset ();
+            light_reset ();
+
+            game_simulation_frame ();
+
+            asteroid_frame ();
+            nebl_process ();
+        }
+
+        Framecount++;
+
+        // the trace events are consumed by the main loop in a normal game
+        tracing::process_events ();
+
+        frames.push_back ({ Missiontime, timer_get_nanoseconds () - start });
+    }
+
+    const auto totals = tracing::totals::get ();
+
+    const char* output =
+        Cmdline_benchmark_output ? Cmdline_benchmark_output : "benchmark.csv";
+
+    if (game_benchmark_json (output)) {
+        game_benchmark_write_json (output, frames, totals);
+    }
+    else {
+        game_benchmark_write_csv (output, frames, totals);
+    }
+
+    std::uint64_t total = 0;
+    for (const auto& frame : frames) { total += frame.duration; }
+
+    II << "benchmark " << mission << ": " << frames.size () << " frames in "
+       << total / 1000000 << " ms";
+
+    freespace_stop_mission ();
+
+    return 0;
+}
+
 /**
  * Does some preliminary checks and then enters main event loop.
  *
@@ -5389,6 +5622,13 @@ int game_main (int argc, char* argv[]) {
         return 0;
     }
 
+    // maybe run the benchmark mission, and exit
+    if (Cmdline_headless_benchmark) {
+        const int result = game_headless_benchmark ();
+        game_shutdown ();
+        return result;
+    }
+
     movie::play ("intro.mve");
 
     gameseq_post_event (GS_EVENT_GAME_INIT);
@@ -6350,6 +6590,8 @@ void game_unpause () {
     }
 }
 
+// the microbenchmarks link the engine with a main of their own
+#if !FS2_MICROBENCHMARK
 int
 main (int argc, char** argv) {
     srand (time (0));
@@ -6366,3 +6608,4 @@ main (int argc, char** argv) {
         return 1;
     }
 }
+#endif // !FS2_MICROBENCHMARK
@@ -168,7 +168,7 @@ void decal_draw_list::render () {
 
     for (auto& draw : _draws) {
         GR_DEBUG_SCOPE ("Draw single decal");
-        TRACE_SCOPE (tracing::RenderSingleDecal);
+        TRACE_DETAIL_SCOPE (tracing::RenderSingleDecal);
 
         gr_bind_uniform_buffer (
             uniform_block_type::DecalInfo, draw.uniform_offset,
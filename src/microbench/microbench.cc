@@ -0,0 +1,564 @@
+// -*- mode: c++; -*-
+
+#include "defs.hh"
+
+//
+// Microbenchmarks of the engine kernels. The engine is initialized as the
+// game would be, with the stub renderer, and every kernel is timed in
+// isolation over synthetic or given data. The results are printed and
+// written as JSON, to compare builds against.
+//
+// usage: fs2bench [<fs2 options>] [-- <benchmark options>]
+//
+//   -o <file>       the JSON results, microbench.json by default
+//   -filter <text>  only the benchmarks whose names contain text
+//   -time <ms>      the least duration of a sample, 20 ms by default
+//   -pof <file>     the model of model_collide, fighter01.pof by default
+//   -table <file>   the table of the parsing benchmarks, ships.tbl by default
+//   -bitmap <file>  a bitmap of the bm_load benchmarks, may be repeated
+//
+
+#include "bmpman/bmpman.hh"
+#include "cfile/cfile.hh"
+#include "cmdline/cmdline.hh"
+#include "ddsutils/ddsutils.hh"
+#include "io/timer.hh"
+#include "math/fvi.hh"
+#include "math/vecmat.hh"
+#include "model/model.hh"
+#include "object/objcollide.hh"
+#include "object/object.hh"
+#include "parse/parselo.hh"
+#include "parse/sexp.hh"
+#include "shared/globals.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+extern void game_init ();
+extern void game_shutdown ();
+
+struct bench_options {
+    std::string output = "microbench.json";
+    std::string filter;
+    std::uint64_t sample_time = 20000000; // nanoseconds
+
+    std::string pof = "fighter01.pof";
+    std::string table = "ships.tbl";
+    std::vector< std::string > bitmaps;
+};
+
+struct bench_result {
+    std::string name;
+    std::uint64_t ops; // operations per sample
+    double min, median, max; // nanoseconds per operation
+};
+
+static bench_options Bench_options;
+static std::vector< bench_result > Bench_results;
+
+// Accumulates the results of the kernels so that they are not optimized out
+static volatile float Bench_sink;
+
+static bool bench_selected (const char* name) {
+    return Bench_options.filter.empty () ||
+           strstr (name, Bench_options.filter.c_str ());
+}
+
+//
+// Times fun, which performs ops operations each call. The number of calls
+// per sample is doubled until a sample lasts at least the sample time, then
+// seven samples are taken.
+//
+template< typename Function >
+static void bench_run (const char* name, size_t ops, Function&& fun) {
+    if (!bench_selected (name)) { return; }
+
+    const int samples = 7;
+
+    fun ();
+
+    std::uint64_t calls = 1;
+    std::uint64_t elapsed = 0;
+
+    for (;;) {
+        const auto start = timer_get_nanoseconds ();
+        for (std::uint64_t i = 0; i < calls; ++i) { fun (); }
+        elapsed = timer_get_nanoseconds () - start;
+
+        if (elapsed >= Bench_options.sample_time || calls >= (1U << 30)) {
+            break;
+        }
+
+        calls *= 2;
+    }
+
+    std::vector< double > times;
+
+    for (int i = 0; i < samples; ++i) {
+        const auto start = timer_get_nanoseconds ();
+        for (std::uint64_t j = 0; j < calls; ++j) { fun (); }
+        elapsed = timer_get_nanoseconds () - start;
+
+        times.push_back (double (elapsed) / double (calls * ops));
+    }
+
+    std::sort (times.begin (), times.end ());
+
+    bench_result result{ name, calls * ops, times.front (),
+                         times[samples / 2], times.back () };
+
+    printf (
+        "%-36s %12.1f ns/op  (min %.1f, max %.1f)\n", name, result.median,
+        result.min, result.max);
+    fflush (stdout);
+
+    Bench_results.push_back (result);
+}
+
+static void bench_skip (const char* name, const char* reason) {
+    if (bench_selected (name)) { printf ("%-36s skipped: %s\n", name, reason); }
+}
+
+static std::mt19937 Bench_random (0x5eed);
+
+static float bench_frand (float lo, float hi) {
+    return std::uniform_real_distribution< float > (lo, hi) (Bench_random);
+}
+
+static vec3d bench_random_vector (float scale) {
+    vec3d v;
+
+    v.xyz.x = bench_frand (-scale, scale);
+    v.xyz.y = bench_frand (-scale, scale);
+    v.xyz.z = bench_frand (-scale, scale);
+
+    return v;
+}
+
+static matrix bench_random_matrix () {
+    angles_t a = { bench_frand (-PI, PI), bench_frand (-PI, PI),
+                   bench_frand (-PI, PI) };
+
+    matrix m;
+    vm_angles_2_matrix (&m, &a);
+
+    return m;
+}
+
+//
+// vecmat
+//
+static void bench_vecmat () {
+    const size_t n = 1024;
+
+    std::vector< vec3d > vectors (n), rotated (n);
+    std::vector< matrix > matrices (n), products (n);
+
+    for (size_t i = 0; i < n; ++i) {
+        vectors[i] = bench_random_vector (100.f);
+        matrices[i] = bench_random_matrix ();
+    }
+
+    bench_run ("vecmat/vm_vec_rotate", n, [&] {
+        for (size_t i = 0; i < n; ++i) {
+            vm_vec_rotate (&rotated[i], &vectors[i], &matrices[i]);
+        }
+
+        Bench_sink = Bench_sink + rotated[n - 1].xyz.x;
+    });
+
+    bench_run ("vecmat/vm_matrix_x_matrix", n, [&] {
+        for (size_t i = 0; i < n; ++i) {
+            vm_matrix_x_matrix (
+                &products[i], &matrices[i], &matrices[(i + 1) % n]);
+        }
+
+        Bench_sink = Bench_sink + products[n - 1].a1d[0];
+    });
+}
+
+//
+// fvi
+//
+static void bench_fvi () {
+    const size_t n = 1024;
+
+    struct segment {
+        vec3d p0, p1, center;
+        float radius;
+    };
+
+    std::vector< segment > segments (n);
+
+    for (auto& s : segments) {
+        s.p0 = bench_random_vector (100.f);
+        s.p1 = bench_random_vector (100.f);
+        s.center = bench_random_vector (50.f);
+        s.radius = bench_frand (5.f, 50.f);
+    }
+
+    bench_run ("fvi/fvi_segment_sphere", n, [&] {
+        int hits = 0;
+        vec3d hit;
+
+        for (auto& s : segments) {
+            hits += fvi_segment_sphere (
+                &hit, &s.p0, &s.p1, &s.center, s.radius);
+        }
+
+        Bench_sink = Bench_sink + float (hits);
+    });
+
+    // Spheres swept towards random triangles around the origin
+    std::vector< vec3d > points (3 * n);
+    for (auto& p : points) { p = bench_random_vector (20.f); }
+
+    std::vector< vec3d > starts (n), directions (n);
+
+    for (size_t i = 0; i < n; ++i) {
+        starts[i] = bench_random_vector (100.f);
+        vm_vec_sub (&directions[i], &points[3 * i], &starts[i]);
+    }
+
+    bench_run ("fvi/fvi_polyedge_sphereline", n, [&] {
+        int hits = 0;
+        vec3d hit;
+        float hit_time;
+
+        for (size_t i = 0; i < n; ++i) {
+            const vec3d* verts[3] = { &points[3 * i], &points[3 * i + 1],
+                                      &points[3 * i + 2] };
+
+            hits += fvi_polyedge_sphereline (
+                &hit, &starts[i], &directions[i], 2.f, 3, verts, &hit_time);
+        }
+
+        Bench_sink = Bench_sink + float (hits);
+    });
+}
+
+//
+// model_collide, with rays through the model from random directions
+//
+static void bench_model_collide () {
+    const char* name = "model/model_collide";
+
+    if (!bench_selected (name)) { return; }
+
+    const int model_num =
+        model_load (Bench_options.pof.c_str (), 0, NULL, 0);
+
+    if (model_num < 0) {
+        bench_skip (name, "cannot load the model");
+        return;
+    }
+
+    const float radius = model_get_radius (model_num);
+
+    const size_t n = 256;
+    std::vector< vec3d > p0 (n), p1 (n);
+
+    for (size_t i = 0; i < n; ++i) {
+        vec3d dir = bench_random_vector (1.f);
+        vm_vec_normalize (&dir);
+
+        vm_vec_copy_scale (&p0[i], &dir, 2.f * radius);
+        vm_vec_copy_scale (&p1[i], &dir, -2.f * radius);
+    }
+
+    matrix orient = vmd_identity_matrix;
+    vec3d pos = vmd_zero_vector;
+
+    bench_run (name, n, [&] {
+        int hits = 0;
+
+        for (size_t i = 0; i < n; ++i) {
+            mc_info mc;
+            mc_info_init (&mc);
+
+            mc.model_num = model_num;
+            mc.orient = &orient;
+            mc.pos = &pos;
+            mc.p0 = &p0[i];
+            mc.p1 = &p1[i];
+            mc.flags = MC_CHECK_MODEL;
+
+            hits += model_collide (&mc);
+        }
+
+        Bench_sink = Bench_sink + float (hits);
+    });
+
+    model_unload (model_num);
+}
+
+//
+// obj_sort_and_collide over clouds of point objects drifting a little every
+// frame; points have no narrow phase, so this times the sort and sweep
+//
+static void bench_object_cloud (const char* name, int count, float size) {
+    if (!bench_selected (name)) { return; }
+
+    flagset< Object::Object_Flags > flags;
+    flags.set (Object::Object_Flags::Collides);
+
+    matrix orient = vmd_identity_matrix;
+
+    std::vector< int > objnums;
+    std::vector< vec3d > velocities;
+
+    for (int i = 0; i < count; ++i) {
+        vec3d pos = bench_random_vector (size);
+
+        const int objnum = obj_create (
+            OBJ_POINT, -1, -1, &orient, &pos, bench_frand (5.f, 50.f), flags);
+
+        if (objnum < 0) { break; }
+
+        obj_add_collider (objnum);
+
+        objnums.push_back (objnum);
+        velocities.push_back (bench_random_vector (1.f));
+    }
+
+    bench_run (name, 1, [&] {
+        for (size_t i = 0; i < objnums.size (); ++i) {
+            vm_vec_add2 (&Objects[objnums[i]].pos, &velocities[i]);
+            obj_hot_update (objnums[i]);
+        }
+
+        obj_sort_and_collide ();
+    });
+
+    for (auto objnum : objnums) { obj_delete (objnum); }
+}
+
+static void bench_objects () {
+    const auto detail_flags = Game_detail_flags;
+    Game_detail_flags |= DETAIL_FLAG_COLLISION;
+
+    bench_object_cloud ("object/obj_sort_and_collide_500", 500, 2000.f);
+    bench_object_cloud ("object/obj_sort_and_collide_2000", 2000, 4000.f);
+
+    Game_detail_flags = detail_flags;
+}
+
+//
+// bm_load, with the data of the bitmap, and the release of its slot
+//
+static int bench_lock_flags (int handle) {
+    switch (bm_is_compressed (handle)) {
+    case DDS_DXT1: return BMP_TEX_DXT1;
+    case DDS_DXT3: return BMP_TEX_DXT3;
+    case DDS_DXT5: return BMP_TEX_DXT5;
+
+    case DDS_CUBEMAP_DXT1:
+    case DDS_CUBEMAP_DXT3:
+    case DDS_CUBEMAP_DXT5: return BMP_TEX_CUBEMAP;
+
+    default: return BMP_TEX_OTHER;
+    }
+}
+
+static void bench_bitmaps () {
+    if (Bench_options.bitmaps.empty ()) {
+        bench_skip ("bmpman/bm_load", "no -bitmap given");
+        return;
+    }
+
+    for (const auto& filename : Bench_options.bitmaps) {
+        const auto name = "bmpman/bm_load " + filename;
+
+        if (!bench_selected (name.c_str ())) { continue; }
+
+        const int probe = bm_load (filename);
+
+        if (probe < 0) {
+            bench_skip (name.c_str (), "cannot load the bitmap");
+            continue;
+        }
+
+        const int flags = bench_lock_flags (probe);
+        bm_release (probe);
+
+        bench_run (name.c_str (), 1, [&] {
+            const int handle = bm_load (filename);
+
+            if (bm_lock (handle, 32, flags)) { bm_unlock (handle); }
+
+            bm_release (handle);
+        });
+    }
+}
+
+//
+// read_file_text, and a scan of the fields of the table
+//
+static void bench_parse () {
+    const char* table = Bench_options.table.c_str ();
+
+    try {
+        read_file_text (table, CF_TYPE_TABLES);
+    }
+    catch (const parse::ParseException&) {
+        bench_skip ("parse/read_file_text", "cannot read the table");
+        return;
+    }
+
+    bench_run ("parse/read_file_text", 1, [&] {
+        read_file_text (table, CF_TYPE_TABLES);
+    });
+
+    bench_run ("parse/table_fields", 1, [&] {
+        int fields = 0;
+        char line[PARSE_BUF_SIZE];
+
+        reset_parse ();
+
+        while (skip_to_start_of_string_either ("$", "+")) {
+            copy_to_eoln (line, NULL, Mp, sizeof line);
+            advance_to_eoln (NULL);
+            ++fields;
+        }
+
+        Bench_sink = Bench_sink + float (fields);
+    });
+
+    stop_parse ();
+}
+
+//
+// eval_sexp over balanced arithmetic trees under a comparison
+//
+static std::string bench_sexp_tree (int depth, int& leaf) {
+    if (depth == 0) { return std::to_string (++leaf % 10); }
+
+    const char* op = depth % 2 ? "+" : "-";
+
+    return std::string ("( ") + op + " " + bench_sexp_tree (depth - 1, leaf) +
+           " " + bench_sexp_tree (depth - 1, leaf) + " )";
+}
+
+static void bench_sexp (const char* name, int depth) {
+    if (!bench_selected (name)) { return; }
+
+    int leaf = 0;
+    std::string text = "( < " + bench_sexp_tree (depth, leaf) + " 100000 )";
+
+    char* old_mp = Mp;
+    Mp = &text[0];
+
+    const int node = get_sexp_main ();
+
+    Mp = old_mp;
+
+    if (node < 0) {
+        bench_skip (name, "cannot parse the sexp");
+        return;
+    }
+
+    bench_run (name, 1, [&] {
+        Bench_sink = Bench_sink + float (eval_sexp (node));
+    });
+
+    free_sexp2 (node);
+}
+
+static void bench_sexps () {
+    bench_sexp ("sexp/eval_sexp_depth4", 4);
+    bench_sexp ("sexp/eval_sexp_depth8", 8);
+}
+
+static void bench_write_json (const char* filename) {
+    std::ofstream out (filename);
+
+    out << "{\n  \"benchmarks\": [";
+
+    for (size_t i = 0; i < Bench_results.size (); ++i) {
+        const auto& result = Bench_results[i];
+
+        out << (i ? "," : "") << "\n    { \"name\": \"" << result.name
+            << "\", \"ops\": " << result.ops
+            << ", \"ns_per_op\": " << result.median
+            << ", \"min_ns_per_op\": " << result.min
+            << ", \"max_ns_per_op\": " << result.max << " }";
+    }
+
+    out << "\n  ]\n}\n";
+}
+
+// The benchmark options follow the game options, after a "--"
+static bool bench_parse_options (int argc, char** argv) {
+    for (int i = 0; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (arg == "-o" && has_value) { Bench_options.output = argv[++i]; }
+        else if (arg == "-filter" && has_value) {
+            Bench_options.filter = argv[++i];
+        }
+        else if (arg == "-time" && has_value) {
+            Bench_options.sample_time =
+                std::uint64_t ((std::max) (1, atoi (argv[++i]))) * 1000000;
+        }
+        else if (arg == "-pof" && has_value) { Bench_options.pof = argv[++i]; }
+        else if (arg == "-table" && has_value) {
+            Bench_options.table = argv[++i];
+        }
+        else if (arg == "-bitmap" && has_value) {
+            Bench_options.bitmaps.push_back (argv[++i]);
+        }
+        else {
+            fprintf (stderr, "fs2bench: unknown option %s\n", argv[i]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main (int argc, char** argv) {
+    int game_argc = argc;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp (argv[i], "--")) {
+            game_argc = i;
+
+            if (!bench_parse_options (argc - i - 1, argv + i + 1)) {
+                return 1;
+            }
+
+            break;
+        }
+    }
+
+    try {
+        if (!parse_cmdline (game_argc, argv)) { return 1; }
+
+        game_init ();
+
+        bench_vecmat ();
+        bench_fvi ();
+        bench_model_collide ();
+        bench_objects ();
+        bench_bitmaps ();
+        bench_parse ();
+        bench_sexps ();
+
+        game_shutdown ();
+    }
+    catch (const std::exception& x) {
+        EE << x.what ();
+        return 1;
+    }
+
+    bench_write_json (Bench_options.output.c_str ());
+
+    return 0;
+}
@@ -263,10 +263,28 @@ struct bsp_collision_leaf {
     int next;
 };
 
+// A node of the four-wide collision tree, collapsed from the binary one. The
+// bounds of the children are stored one axis at a time so that a ray can be
+// tested against all four boxes at once.
+#define BSP_WIDE_NODE_CHILDREN 4
+
+struct bsp_collision_wide_node {
+    float min[3][BSP_WIDE_NODE_CHILDREN];
+    float max[3][BSP_WIDE_NODE_CHILDREN];
+
+    int child[BSP_WIDE_NODE_CHILDREN]; // wide node index or -1
+    int leaf[BSP_WIDE_NODE_CHILDREN];  // first leaf of a polygon list or -1
+
+    int n_children;
+};
+
 struct bsp_collision_tree {
     bsp_collision_node* node_list;
     int n_nodes;
 
+    bsp_collision_wide_node* wide_node_list;
+    int n_wide_nodes;
+
     bsp_collision_leaf* leaf_list;
     int n_leaves;
 
@@ -1355,6 +1373,17 @@ inline void mc_info_init (mc_info* mc) {
 */
 
 int model_collide (mc_info* mc_info_obj);
+
+// The largest number of rays model_collide_packet traverses the model with at
+// once
+#define MC_PACKET_SIZE 8
+
+// Checks several queries against one model in a single traversal of its
+// collision trees, e.g. the rays of a beam or of several turrets. All the
+// queries must share the model, instance, orientation, position, flags, lod
+// and radius, but have their own p0 and p1. Each one gets the same results
+// model_collide would have given it. Returns the number of queries that hit.
+int model_collide_packet (mc_info* mc_list, int count);
 void model_collide_parse_bsp (
     bsp_collision_tree* tree, void* model_ptr, int version);
 
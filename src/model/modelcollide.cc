@@ -7,6 +7,7 @@
 #define MODEL_LIB
 
 #include "cmdline/cmdline.hh"
+#include "debugconsole/console.hh"
 #include "graphics/tmapper.hh"
 #include "math/fvi.hh"
 #include "math/vecmat.hh"
@@ -14,65 +15,80 @@
 #include "model/modelsinc.hh"
 #include "tracing/tracing.hh"
 #include "tracing/Monitor.hh"
+#include "io/timer.hh"
+
+#include <thread>
+
+#if defined(__SSE__) || _M_IX86_FP >= 1
+#include <xmmintrin.h>
+#endif
 
 #define TOL 1E-4
 #define DIST_TOL 1.0
 
-// Some global variables that get set by model_collide and are used internally
-// for checking a collision rather than passing a bunch of parameters around.
-// These are not persistant between calls to model_collide
+// The state of a single model_collide query. It gets set up by model_collide
+// and is passed down to the internal routines rather than passing a bunch of
+// parameters around. Keeping it out of globals lets several queries run at
+// the same time from different threads.
+struct mc_context {
+    mc_info* mc; // The mc_info passed into model_collide
 
-static mc_info* Mc; // The mc_info passed into model_collide
+    polymodel* pm; // The polygon model we're checking
+    int submodel;  // The current submodel we're checking
 
-static polymodel* Mc_pm; // The polygon model we're checking
-static int Mc_submodel;  // The current submodel we're checking
+    polymodel_instance* pmi;
 
-static polymodel_instance* Mc_pmi;
+    matrix orient; // A matrix to rotate a world point into the current
+                   // submodel's frame of reference.
+    vec3d base;    // A point used along with orient.
 
-static matrix Mc_orient; // A matrix to rotate a world point into the current
-                         // submodel's frame of reference.
-static vec3d Mc_base;    // A point used along with Mc_orient.
+    vec3d p0;        // The ray origin rotated into the current submodel's
+                     // frame of reference
+    vec3d p1;        // The ray end rotated into the current submodel's frame
+                     // of reference
+    float mag;       // The length of the ray
+    vec3d direction; // A vector from the ray's origin to its end, in the
+                     // current submodel's frame of reference
 
-static vec3d Mc_p0; // The ray origin rotated into the current submodel's frame
-                    // of reference
-static vec3d Mc_p1; // The ray end rotated into the current submodel's frame of
-                    // reference
-static float Mc_mag;       // The length of the ray
-static vec3d Mc_direction; // A vector from the ray's origin to its end, in the
-                           // current submodel's frame of reference
+    vec3d** point_list; // A pointer to the current submodel's vertex list
 
-static vec3d** Mc_point_list =
-    NULL; // A pointer to the current submodel's vertex list
+    float edge_time;
+};
 
-static float Mc_edge_time;
+// The largest vertex count of any loaded submodel; every thread keeps its own
+// point list of that size for the old (non-BSP tree) collision code.
+static int Mc_point_list_size = 0;
 
-void model_collide_free_point_list () {
-    if (Mc_point_list != NULL) {
-        free (Mc_point_list);
-        Mc_point_list = NULL;
+static std::vector< vec3d* >& mc_get_point_list () {
+    thread_local std::vector< vec3d* > point_list;
+
+    if (point_list.size () < size_t (Mc_point_list_size)) {
+        point_list.resize (Mc_point_list_size);
     }
+
+    return point_list;
+}
+
+void model_collide_free_point_list () {
+    std::vector< vec3d* > ().swap (mc_get_point_list ());
 }
 
-// allocate the point list
+// record the size of the point list
 // NOTE: SHOULD ONLY EVER BE CALLED FROM model_allocate_interp_data()!!!
 void model_collide_allocate_point_list (int n_points) {
     ASSERT (n_points > 0);
 
-    if (Mc_point_list != NULL) {
-        free (Mc_point_list);
-        Mc_point_list = NULL;
-    }
-
-    Mc_point_list = (vec3d**)malloc (sizeof (vec3d*) * n_points);
-
-    ASSERT (Mc_point_list != NULL);
+    if (n_points > Mc_point_list_size) { Mc_point_list_size = n_points; }
 }
 
 // Returns non-zero if vector from p0 to pdir
 // intersects the bounding box.
 // hitpos could be NULL, so don't fill it if it is.
 int mc_ray_boundingbox (
-    vec3d* min, vec3d* max, vec3d* p0, vec3d* pdir, vec3d* hitpos) {
+    mc_context* ctx, vec3d* min, vec3d* max, vec3d* p0, vec3d* pdir,
+    vec3d* hitpos) {
+    mc_info* Mc = ctx->mc;
+
     vec3d tmp_hitpos;
     if (hitpos == NULL) { hitpos = &tmp_hitpos; }
 
@@ -107,22 +123,24 @@ int mc_ray_boundingbox (
 // ntmap -- The tmap index into the model's textures array.
 //
 // detects whether or not a vector has collided with a polygon.  vector points
-// stored in global Mc_p0 and Mc_p1.  Results stored in global mc_info * Mc.
+// stored in ctx->p0 and ctx->p1.  Results stored in ctx->mc.
 
 static void mc_check_face (
-    int nv, vec3d** verts, vec3d* plane_pnt, vec3d* plane_norm,
+    mc_context* ctx, int nv, vec3d** verts, vec3d* plane_pnt, vec3d* plane_norm,
     uv_pair* uvl_list, int ntmap, ubyte* poly, bsp_collision_leaf* bsp_leaf) {
+    mc_info* Mc = ctx->mc;
+
     vec3d hit_point;
     float dist;
     float u, v;
 
     // Check to see if poly is facing away from ray.  If so, don't bother
     // checking it.
-    if (vm_vec_dot (&Mc_direction, plane_norm) > 0.0f) { return; }
+    if (vm_vec_dot (&ctx->direction, plane_norm) > 0.0f) { return; }
 
     // Find the intersection of this ray with the plane that the poly
     dist = fvi_ray_plane (
-        NULL, plane_pnt, plane_norm, &Mc_p0, &Mc_direction, 0.0f);
+        NULL, plane_pnt, plane_norm, &ctx->p0, &ctx->direction, 0.0f);
 
     if (dist < 0.0f)
         return; // If the ray is behind the plane there is no collision
@@ -134,7 +152,7 @@ static void mc_check_face (
     if (Mc->num_hits && (dist >= Mc->hit_dist)) return;
 
     // Find the hit point
-    vm_vec_scale_add (&hit_point, &Mc_p0, &Mc_direction, dist);
+    vm_vec_scale_add (&hit_point, &ctx->p0, &ctx->direction, dist);
 
     // Check to see if the point of intersection is on the plane.  If so, this
     // also finds the uv's where the ray hit.
@@ -142,7 +160,7 @@ static void mc_check_face (
         Mc->hit_dist = dist;
 
         Mc->hit_point = hit_point;
-        Mc->hit_submodel = Mc_submodel;
+        Mc->hit_submodel = ctx->submodel;
 
         Mc->hit_normal = *plane_norm;
 
@@ -152,7 +170,7 @@ static void mc_check_face (
             if (ntmap < 0) { Mc->hit_bitmap = -1; }
             else {
                 Mc->hit_bitmap =
-                    Mc_pm->maps[ntmap].textures[TM_BASE_TYPE].GetTexture ();
+                    ctx->pm->maps[ntmap].textures[TM_BASE_TYPE].GetTexture ();
             }
         }
 
@@ -183,8 +201,10 @@ static void mc_check_face (
 // plane_norm
 //=>            normal of face
 static void mc_check_sphereline_face (
-    int nv, vec3d** verts, vec3d* plane_pnt, vec3d* plane_norm,
+    mc_context* ctx, int nv, vec3d** verts, vec3d* plane_pnt, vec3d* plane_norm,
     uv_pair* uvl_list, int ntmap, ubyte* poly, bsp_collision_leaf* bsp_leaf) {
+    mc_info* Mc = ctx->mc;
+
     vec3d hit_point;
     float u, v;
     float delta_t; // time sphere takes to cross from one side of plane to the
@@ -198,11 +218,11 @@ static void mc_check_sphereline_face (
     // Check to see if poly is facing away from ray.  If so, don't bother
     // checking it.
 
-    if (vm_vec_dot (&Mc_direction, plane_norm) > 0.0f) { return; }
+    if (vm_vec_dot (&ctx->direction, plane_norm) > 0.0f) { return; }
 
     // Find the intersection of this sphere with the plane of the poly
     if (!fvi_sphere_plane (
-            &hit_point, &Mc_p0, &Mc_direction, Mc->radius, plane_norm,
+            &hit_point, &ctx->p0, &ctx->direction, Mc->radius, plane_norm,
             plane_pnt, &face_t, &delta_t)) {
         return;
     }
@@ -244,7 +264,7 @@ static void mc_check_sphereline_face (
             Mc->hit_dist = face_t;
             Mc->hit_point = hit_point;
             Mc->hit_normal = *plane_norm;
-            Mc->hit_submodel = Mc_submodel;
+            Mc->hit_submodel = ctx->submodel;
             Mc->edge_hit = 0;
 
             if (uvl_list) {
@@ -252,7 +272,7 @@ static void mc_check_sphereline_face (
                 Mc->hit_v = v;
                 if (ntmap < 0) { Mc->hit_bitmap = -1; }
                 else {
-                    Mc->hit_bitmap = Mc_pm->maps[ntmap]
+                    Mc->hit_bitmap = ctx->pm->maps[ntmap]
                                          .textures[TM_BASE_TYPE]
                                          .GetTexture ();
                 }
@@ -272,7 +292,7 @@ static void mc_check_sphereline_face (
             Mc->num_hits++;
             check_edges = 0;
             /*
-            vm_vec_scale_add( &temp_sphere, &Mc_p0, &Mc_direction, Mc->hit_dist
+            vm_vec_scale_add( &temp_sphere, &ctx->p0, &ctx->direction, Mc->hit_dist
             ); temp_dist = vm_vec_dist( &temp_sphere, &hit_point ); if (
             (temp_dist - DIST_TOL > Mc->radius) || (temp_dist + DIST_TOL <
             Mc->radius) ) {
@@ -281,7 +301,7 @@ static void mc_check_sphereline_face (
             Mc->radius\n", temp_dist, Mc->radius));
             }
             vm_vec_sub( &temp_dir, &hit_point, &temp_sphere );
-            // ASSERT (vm_vec_dot( &temp_dir, &Mc_direction ) > 0 );
+            // ASSERT (vm_vec_dot( &temp_dir, &ctx->direction ) > 0 );
             */
         }
     }
@@ -299,11 +319,11 @@ static void mc_check_sphereline_face (
         // Mc->hit_dist stores the best edge time of *all* faces
         float sphere_time;
         if (fvi_polyedge_sphereline (
-                &hit_point, &Mc_p0, &Mc_direction, Mc->radius, nv, verts,
+                &hit_point, &ctx->p0, &ctx->direction, Mc->radius, nv, verts,
                 &sphere_time)) {
             ASSERT (sphere_time >= 0.0f);
             /*
-            vm_vec_scale_add( &temp_sphere, &Mc_p0, &Mc_direction, sphere_time
+            vm_vec_scale_add( &temp_sphere, &ctx->p0, &ctx->direction, sphere_time
 ); temp_dist = vm_vec_dist( &temp_sphere, &hit_point ); if ( (temp_dist -
 DIST_TOL > Mc->radius) || (temp_dist + DIST_TOL < Mc->radius) ) {
                 // get Andsager
@@ -311,18 +331,18 @@ DIST_TOL > Mc->radius) || (temp_dist + DIST_TOL < Mc->radius) ) {
 Mc->radius\n", temp_dist, Mc->radius));
             }
             vm_vec_sub( &temp_dir, &hit_point, &temp_sphere );
-// ASSERT (vm_vec_dot( &temp_dir, &Mc_direction ) > 0 );
+// ASSERT (vm_vec_dot( &temp_dir, &ctx->direction ) > 0 );
             */
 
             if ((Mc->num_hits == 0) || (sphere_time < Mc->hit_dist)) {
                 // This is closer than best so far
                 Mc->hit_dist = sphere_time;
                 Mc->hit_point = hit_point;
-                Mc->hit_submodel = Mc_submodel;
+                Mc->hit_submodel = ctx->submodel;
                 Mc->edge_hit = 1;
                 if (ntmap < 0) { Mc->hit_bitmap = -1; }
                 else {
-                    Mc->hit_bitmap = Mc_pm->maps[ntmap]
+                    Mc->hit_bitmap = ctx->pm->maps[ntmap]
                                          .textures[TM_BASE_TYPE]
                                          .GetTexture ();
                 }
@@ -356,7 +376,7 @@ Mc->radius\n", temp_dist, Mc->radius));
 // +20     n_verts*char    norm_counts
 // +offset             vertex data. Each vertex n is a point followed by
 // norm_counts[n] normals.
-void model_collide_defpoints (ubyte* p) {
+void model_collide_defpoints (mc_context* ctx, ubyte* p) {
     int n;
     int nverts = w (p + 8);
     int offset = w (p + 16);
@@ -364,16 +384,17 @@ void model_collide_defpoints (ubyte* p) {
     ubyte* normcount = p + 20;
     vec3d* src = vp (p + offset);
 
-    ASSERT (Mc_point_list != NULL);
+    ASSERT (ctx->point_list != NULL);
 
     for (n = 0; n < nverts; n++) {
-        Mc_point_list[n] = src;
+        ctx->point_list[n] = src;
 
         src += normcount[n] + 1;
     }
 }
 
-int model_collide_parse_bsp_defpoints (ubyte* p) {
+int model_collide_parse_bsp_defpoints (
+    std::vector< vec3d* >* point_list, ubyte* p) {
     int n;
     int nverts = w (p + 8);
     int offset = w (p + 16);
@@ -381,12 +402,10 @@ int model_collide_parse_bsp_defpoints (ubyte* p) {
     ubyte* normcount = p + 20;
     vec3d* src = vp (p + offset);
 
-    model_collide_allocate_point_list (nverts);
-
-    ASSERT (Mc_point_list != NULL);
+    point_list->resize (nverts);
 
     for (n = 0; n < nverts; n++) {
-        Mc_point_list[n] = src;
+        (*point_list)[n] = src;
 
         src += normcount[n] + 1;
     }
@@ -406,7 +425,9 @@ int model_collide_parse_bsp_defpoints (ubyte* p) {
 // +42     byte        blue
 // +43     byte        pad
 // +44     nverts*int  vertlist
-void model_collide_flatpoly (ubyte* p) {
+void model_collide_flatpoly (mc_context* ctx, ubyte* p) {
+    mc_info* Mc = ctx->mc;
+
     int i;
     int nv;
     vec3d* points[TMAP_MAX_VERTS];
@@ -423,14 +444,15 @@ void model_collide_flatpoly (ubyte* p) {
 
     verts = (short*)(p + 44);
 
-    for (i = 0; i < nv; i++) { points[i] = Mc_point_list[verts[i * 2]]; }
+    for (i = 0; i < nv; i++) { points[i] = ctx->point_list[verts[i * 2]]; }
 
     if (Mc->flags & MC_CHECK_SPHERELINE) {
         mc_check_sphereline_face (
-            nv, points, vp (p + 20), vp (p + 8), NULL, -1, p, NULL);
+            ctx, nv, points, vp (p + 20), vp (p + 8), NULL, -1, p, NULL);
     }
     else {
-        mc_check_face (nv, points, vp (p + 20), vp (p + 8), NULL, -1, p, NULL);
+        mc_check_face (
+            ctx, nv, points, vp (p + 20), vp (p + 8), NULL, -1, p, NULL);
     }
 }
 
@@ -443,7 +465,9 @@ void model_collide_flatpoly (ubyte* p) {
 // +36     int         nverts
 // +40     int         tmap_num
 // +44     nverts*(model_tmap_vert) vertlist (n,u,v)
-void model_collide_tmappoly (ubyte* p) {
+void model_collide_tmappoly (mc_context* ctx, ubyte* p) {
+    mc_info* Mc = ctx->mc;
+
     int i;
     int nv;
     uv_pair uvlist[TMAP_MAX_VERTS];
@@ -463,27 +487,29 @@ void model_collide_tmappoly (ubyte* p) {
     ASSERT (tmap_num >= 0 && tmap_num < MAX_MODEL_TEXTURES); // Goober5000
 
     if ((!(Mc->flags & MC_CHECK_INVISIBLE_FACES)) &&
-        (Mc_pm->maps[tmap_num].textures[TM_BASE_TYPE].GetTexture () < 0)) {
+        (ctx->pm->maps[tmap_num].textures[TM_BASE_TYPE].GetTexture () < 0)) {
         // Don't check invisible polygons.
         // SUSHI: Unless $collide_invisible is set.
-        if (!(Mc_pm->submodel[Mc_submodel].collide_invisible)) return;
+        if (!(ctx->pm->submodel[ctx->submodel].collide_invisible)) return;
     }
 
     verts = (model_tmap_vert*)(p + 44);
 
     for (i = 0; i < nv; i++) {
-        points[i] = Mc_point_list[verts[i].vertnum];
+        points[i] = ctx->point_list[verts[i].vertnum];
         uvlist[i].u = verts[i].u;
         uvlist[i].v = verts[i].v;
     }
 
     if (Mc->flags & MC_CHECK_SPHERELINE) {
         mc_check_sphereline_face (
-            nv, points, vp (p + 20), vp (p + 8), uvlist, tmap_num, p, NULL);
+            ctx, nv, points, vp (p + 20), vp (p + 8), uvlist, tmap_num, p,
+            NULL);
     }
     else {
         mc_check_face (
-            nv, points, vp (p + 20), vp (p + 8), uvlist, tmap_num, p, NULL);
+            ctx, nv, points, vp (p + 20), vp (p + 8), uvlist, tmap_num, p,
+            NULL);
     }
 }
 
@@ -499,9 +525,11 @@ void model_collide_tmappoly (ubyte* p) {
 // 48     int     postlist offset
 // 52     int     online offset
 
-int model_collide_sub (void* model_ptr);
+int model_collide_sub (mc_context* ctx, void* model_ptr);
+
+void model_collide_sortnorm (mc_context* ctx, ubyte* p) {
+    mc_info* Mc = ctx->mc;
 
-void model_collide_sortnorm (ubyte* p) {
     int frontlist = w (p + 36);
     int backlist = w (p + 40);
     int prelist = w (p + 44);
@@ -509,11 +537,12 @@ void model_collide_sortnorm (ubyte* p) {
     int onlist = w (p + 52);
     vec3d hitpos;
 
-    if (Mc_pm->version >= 2000) {
+    if (ctx->pm->version >= 2000) {
         if (mc_ray_boundingbox (
-                vp (p + 56), vp (p + 68), &Mc_p0, &Mc_direction, &hitpos)) {
+                ctx, vp (p + 56), vp (p + 68), &ctx->p0, &ctx->direction,
+                &hitpos)) {
             if (!(Mc->flags & MC_CHECK_RAY) &&
-                (vm_vec_dist (&hitpos, &Mc_p0) > Mc_mag)) {
+                (vm_vec_dist (&hitpos, &ctx->p0) > ctx->mag)) {
                 return;
             }
         }
@@ -522,16 +551,18 @@ void model_collide_sortnorm (ubyte* p) {
         }
     }
 
-    if (prelist) model_collide_sub (p + prelist);
-    if (backlist) model_collide_sub (p + backlist);
-    if (onlist) model_collide_sub (p + onlist);
-    if (frontlist) model_collide_sub (p + frontlist);
-    if (postlist) model_collide_sub (p + postlist);
+    if (prelist) model_collide_sub (ctx, p + prelist);
+    if (backlist) model_collide_sub (ctx, p + backlist);
+    if (onlist) model_collide_sub (ctx, p + onlist);
+    if (frontlist) model_collide_sub (ctx, p + frontlist);
+    if (postlist) model_collide_sub (ctx, p + postlist);
 }
 
 // calls the object interpreter to render an object.  The object renderer
 // is really a seperate pipeline. returns true if drew
-int model_collide_sub (void* model_ptr) {
+int model_collide_sub (mc_context* ctx, void* model_ptr) {
+    mc_info* Mc = ctx->mc;
+
     ubyte* p = (ubyte*)model_ptr;
     int chunk_type, chunk_size;
     vec3d hitpos;
@@ -544,15 +575,16 @@ int model_collide_sub (void* model_ptr) {
         // chunk_size ));
 
         switch (chunk_type) {
-        case OP_DEFPOINTS: model_collide_defpoints (p); break;
-        case OP_FLATPOLY: model_collide_flatpoly (p); break;
-        case OP_TMAPPOLY: model_collide_tmappoly (p); break;
-        case OP_SORTNORM: model_collide_sortnorm (p); break;
+        case OP_DEFPOINTS: model_collide_defpoints (ctx, p); break;
+        case OP_FLATPOLY: model_collide_flatpoly (ctx, p); break;
+        case OP_TMAPPOLY: model_collide_tmappoly (ctx, p); break;
+        case OP_SORTNORM: model_collide_sortnorm (ctx, p); break;
         case OP_BOUNDBOX:
             if (mc_ray_boundingbox (
-                    vp (p + 8), vp (p + 20), &Mc_p0, &Mc_direction, &hitpos)) {
+                    ctx, vp (p + 8), vp (p + 20), &ctx->p0, &ctx->direction,
+                    &hitpos)) {
                 if (!(Mc->flags & MC_CHECK_RAY) &&
-                    (vm_vec_dist (&hitpos, &Mc_p0) > Mc_mag)) {
+                    (vm_vec_dist (&hitpos, &ctx->p0) > ctx->mag)) {
                     // The ray isn't long enough to intersect the bounding box
                     return 1;
                 }
@@ -573,7 +605,10 @@ int model_collide_sub (void* model_ptr) {
     return 1;
 }
 
-void model_collide_bsp_poly (bsp_collision_tree* tree, int leaf_index) {
+void model_collide_bsp_poly (
+    mc_context* ctx, bsp_collision_tree* tree, int leaf_index) {
+    mc_info* Mc = ctx->mc;
+
     int i;
     int tested_leaf = leaf_index;
     uv_pair uvlist[TMAP_MAX_VERTS];
@@ -588,12 +623,13 @@ void model_collide_bsp_poly (bsp_collision_tree* tree, int leaf_index) {
 
         if (leaf->tmap_num < MAX_MODEL_TEXTURES) {
             if ((!(Mc->flags & MC_CHECK_INVISIBLE_FACES)) &&
-                (Mc_pm->maps[leaf->tmap_num]
+                (ctx->pm->maps[leaf->tmap_num]
                      .textures[TM_BASE_TYPE]
                      .GetTexture () < 0)) {
                 // Don't check invisible polygons.
                 // SUSHI: Unless $collide_invisible is set.
-                if (!(Mc_pm->submodel[Mc_submodel].collide_invisible)) return;
+                if (!(ctx->pm->submodel[ctx->submodel].collide_invisible))
+                    return;
             }
         }
         else {
@@ -612,25 +648,25 @@ void model_collide_bsp_poly (bsp_collision_tree* tree, int leaf_index) {
         if (flat_poly) {
             if (Mc->flags & MC_CHECK_SPHERELINE) {
                 mc_check_sphereline_face (
-                    nv, points, &leaf->plane_pnt, &leaf->plane_norm, NULL, -1,
-                    NULL, leaf);
+                    ctx, nv, points, &leaf->plane_pnt, &leaf->plane_norm,
+                    NULL, -1, NULL, leaf);
             }
             else {
                 mc_check_face (
-                    nv, points, &leaf->plane_pnt, &leaf->plane_norm, NULL, -1,
-                    NULL, leaf);
+                    ctx, nv, points, &leaf->plane_pnt, &leaf->plane_norm,
+                    NULL, -1, NULL, leaf);
             }
         }
         else {
             if (Mc->flags & MC_CHECK_SPHERELINE) {
                 mc_check_sphereline_face (
-                    nv, points, &leaf->plane_pnt, &leaf->plane_norm, uvlist,
-                    leaf->tmap_num, NULL, leaf);
+                    ctx, nv, points, &leaf->plane_pnt, &leaf->plane_norm,
+                    uvlist, leaf->tmap_num, NULL, leaf);
             }
             else {
                 mc_check_face (
-                    nv, points, &leaf->plane_pnt, &leaf->plane_norm, uvlist,
-                    leaf->tmap_num, NULL, leaf);
+                    ctx, nv, points, &leaf->plane_pnt, &leaf->plane_norm,
+                    uvlist, leaf->tmap_num, NULL, leaf);
             }
         }
 
@@ -638,26 +674,147 @@ void model_collide_bsp_poly (bsp_collision_tree* tree, int leaf_index) {
     }
 }
 
-void model_collide_bsp (bsp_collision_tree* tree, int node_index) {
-    if (tree->node_list == NULL || tree->n_verts <= 0) { return; }
+// A ray set up for testing against the four boxes of a wide node at once
+struct mc_wide_ray {
+    float p0[3];
+    float inv_dir[3]; // finite even for axes the ray doesn't move along
+    float radius;     // the boxes grow by this much for sphere checks
+    float limit;      // the farthest entry into a box, in ray lengths
+};
 
-    bsp_collision_node* node = &tree->node_list[node_index];
-    vec3d hitpos;
+static void mc_wide_ray_init (mc_context* ctx, mc_wide_ray* ray) {
+    mc_info* Mc = ctx->mc;
 
-    // check the bounding box of this node. if it passes, check left and right
-    // children
-    if (mc_ray_boundingbox (
-            &node->min, &node->max, &Mc_p0, &Mc_direction, &hitpos)) {
-        if (!(Mc->flags & MC_CHECK_RAY) &&
-            (vm_vec_dist (&hitpos, &Mc_p0) > Mc_mag)) {
-            // The ray isn't long enough to intersect the bounding box
-            return;
+    for (int axis = 0; axis < 3; ++axis) {
+        float dir = ctx->direction.a1d[axis];
+
+        ray->p0[axis] = ctx->p0.a1d[axis];
+        ray->inv_dir[axis] = (dir != 0.0f) ? 1.0f / dir : 1e30f;
+    }
+
+    ray->radius = (Mc->flags & MC_CHECK_SPHERELINE) ? Mc->radius : 0.0f;
+    ray->limit = (Mc->flags & MC_CHECK_RAY) ? FLT_MAX : 1.0f;
+}
+
+// Returns a mask of the children of the node whose box the ray enters, the
+// slab test version of mc_ray_boundingbox plus the ray length check.
+static int mc_ray_wide_boundingbox (
+    const mc_wide_ray* ray, const bsp_collision_wide_node* node) {
+#if defined(__SSE__) || _M_IX86_FP >= 1
+    const __m128 radius = _mm_set1_ps (ray->radius);
+
+    __m128 tnear = _mm_set1_ps (-FLT_MAX);
+    __m128 tfar = _mm_set1_ps (FLT_MAX);
+
+    for (int axis = 0; axis < 3; ++axis) {
+        const __m128 p0 = _mm_set1_ps (ray->p0[axis]);
+        const __m128 inv_dir = _mm_set1_ps (ray->inv_dir[axis]);
+
+        __m128 lo = _mm_sub_ps (_mm_loadu_ps (node->min[axis]), radius);
+        __m128 hi = _mm_add_ps (_mm_loadu_ps (node->max[axis]), radius);
+
+        __m128 t0 = _mm_mul_ps (_mm_sub_ps (lo, p0), inv_dir);
+        __m128 t1 = _mm_mul_ps (_mm_sub_ps (hi, p0), inv_dir);
+
+        tnear = _mm_max_ps (tnear, _mm_min_ps (t0, t1));
+        tfar = _mm_min_ps (tfar, _mm_max_ps (t0, t1));
+    }
+
+    __m128 hit = _mm_and_ps (
+        _mm_cmple_ps (tnear, tfar), _mm_cmpge_ps (tfar, _mm_setzero_ps ()));
+    hit = _mm_and_ps (hit, _mm_cmple_ps (tnear, _mm_set1_ps (ray->limit)));
+
+    return _mm_movemask_ps (hit) & ((1 << node->n_children) - 1);
+#else
+    int mask = 0;
+
+    for (int i = 0; i < node->n_children; ++i) {
+        float tnear = -FLT_MAX;
+        float tfar = FLT_MAX;
+
+        for (int axis = 0; axis < 3; ++axis) {
+            float lo = node->min[axis][i] - ray->radius;
+            float hi = node->max[axis][i] + ray->radius;
+
+            float t0 = (lo - ray->p0[axis]) * ray->inv_dir[axis];
+            float t1 = (hi - ray->p0[axis]) * ray->inv_dir[axis];
+
+            tnear = (std::max) (tnear, (std::min) (t0, t1));
+            tfar = (std::min) (tfar, (std::max) (t0, t1));
         }
 
-        if (node->leaf >= 0) { model_collide_bsp_poly (tree, node->leaf); }
-        else {
-            if (node->back >= 0) model_collide_bsp (tree, node->back);
-            if (node->front >= 0) model_collide_bsp (tree, node->front);
+        if (tnear <= tfar && tfar >= 0.0f && tnear <= ray->limit) {
+            mask |= 1 << i;
+        }
+    }
+
+    return mask;
+#endif
+}
+
+// Checks the rays of the packet whose bits are set in rays against the
+// polygons of a collision tree. The tree is walked once for all of them, in
+// the same order as the binary tree it was built from.
+void model_collide_bsp (
+    mc_context* ctxs, uint rays, bsp_collision_tree* tree) {
+    if (tree->wide_node_list == NULL || tree->n_verts <= 0) { return; }
+
+    struct entry {
+        int index; // wide node or leaf index
+        bool leaf;
+        uint rays;
+    };
+
+    thread_local std::vector< entry > stack;
+    stack.clear ();
+
+    mc_wide_ray wide_rays[MC_PACKET_SIZE];
+
+    for (int k = 0; k < MC_PACKET_SIZE; ++k) {
+        if (rays & (1U << k)) { mc_wide_ray_init (&ctxs[k], &wide_rays[k]); }
+    }
+
+    stack.push_back ({ 0, false, rays });
+
+    while (!stack.empty ()) {
+        const entry current = stack.back ();
+        stack.pop_back ();
+
+        if (current.leaf) {
+            for (int k = 0; k < MC_PACKET_SIZE; ++k) {
+                if (current.rays & (1U << k)) {
+                    model_collide_bsp_poly (&ctxs[k], tree, current.index);
+                }
+            }
+
+            continue;
+        }
+
+        const bsp_collision_wide_node* node =
+            &tree->wide_node_list[current.index];
+
+        uint child_rays[BSP_WIDE_NODE_CHILDREN] = { 0 };
+
+        for (int k = 0; k < MC_PACKET_SIZE; ++k) {
+            if (!(current.rays & (1U << k))) { continue; }
+
+            int hits = mc_ray_wide_boundingbox (&wide_rays[k], node);
+
+            for (int i = 0; i < node->n_children; ++i) {
+                if (hits & (1 << i)) { child_rays[i] |= 1U << k; }
+            }
+        }
+
+        // push in reverse so that the first child is checked first
+        for (int i = node->n_children - 1; i >= 0; --i) {
+            if (!child_rays[i]) { continue; }
+
+            if (node->leaf[i] >= 0) {
+                stack.push_back ({ node->leaf[i], true, child_rays[i] });
+            }
+            else if (node->child[i] >= 0) {
+                stack.push_back ({ node->child[i], false, child_rays[i] });
+            }
         }
     }
 }
@@ -745,6 +902,112 @@ void model_collide_parse_bsp_flatpoly (
     }
 }
 
+// The surface area of the box of a node; the largest boxes get opened first
+// when collapsing the binary tree.
+static float mc_node_area (const bsp_collision_node& node) {
+    vec3d size;
+    vm_vec_sub (&size, &node.max, &node.min);
+
+    return size.xyz.x * size.xyz.y + size.xyz.y * size.xyz.z +
+           size.xyz.z * size.xyz.x;
+}
+
+// Collapses the binary subtree below node_index into a wide node holding up to
+// four of its descendants, in the order the binary tree would visit them, and
+// returns the index of the new wide node.
+static int model_collide_build_wide_node (
+    const std::vector< bsp_collision_node >& nodes, int node_index,
+    std::vector< bsp_collision_wide_node >* wide_nodes) {
+    const bsp_collision_node& node = nodes[node_index];
+
+    int candidates[BSP_WIDE_NODE_CHILDREN];
+    int n = 0;
+
+    if (node.leaf >= 0) { candidates[n++] = node_index; }
+    else {
+        if (node.back >= 0) { candidates[n++] = node.back; }
+        if (node.front >= 0) { candidates[n++] = node.front; }
+    }
+
+    // replace the largest inner node with its children until the wide node
+    // is full or only has leaves left
+    while (n < BSP_WIDE_NODE_CHILDREN) {
+        int best = -1;
+        float best_area = -1.0f;
+
+        for (int i = 0; i < n; ++i) {
+            const bsp_collision_node& candidate = nodes[candidates[i]];
+
+            if (candidate.leaf >= 0) { continue; }
+
+            float area = mc_node_area (candidate);
+
+            if (best < 0 || area > best_area) {
+                best = i;
+                best_area = area;
+            }
+        }
+
+        if (best < 0) { break; }
+
+        const bsp_collision_node& opened = nodes[candidates[best]];
+
+        int children[2];
+        int n_children = 0;
+
+        if (opened.back >= 0) { children[n_children++] = opened.back; }
+        if (opened.front >= 0) { children[n_children++] = opened.front; }
+
+        memmove (
+            &candidates[best + n_children], &candidates[best + 1],
+            sizeof (int) * (n - best - 1));
+
+        for (int i = 0; i < n_children; ++i) {
+            candidates[best + i] = children[i];
+        }
+
+        n += n_children - 1;
+    }
+
+    // the recursion below may move the buffer, so fill in a copy
+    int index = (int)wide_nodes->size ();
+    wide_nodes->push_back (bsp_collision_wide_node ());
+
+    bsp_collision_wide_node wide;
+
+    for (int i = 0; i < BSP_WIDE_NODE_CHILDREN; ++i) {
+        wide.child[i] = -1;
+        wide.leaf[i] = -1;
+
+        if (i >= n) {
+            for (int axis = 0; axis < 3; ++axis) {
+                wide.min[axis][i] = FLT_MAX;
+                wide.max[axis][i] = -FLT_MAX;
+            }
+
+            continue;
+        }
+
+        const bsp_collision_node& child = nodes[candidates[i]];
+
+        for (int axis = 0; axis < 3; ++axis) {
+            wide.min[axis][i] = child.min.a1d[axis];
+            wide.max[axis][i] = child.max.a1d[axis];
+        }
+
+        if (child.leaf >= 0) { wide.leaf[i] = child.leaf; }
+        else {
+            wide.child[i] = model_collide_build_wide_node (
+                nodes, candidates[i], wide_nodes);
+        }
+    }
+
+    wide.n_children = n;
+    (*wide_nodes)[index] = wide;
+
+    return index;
+}
+
 void model_collide_parse_bsp (
     bsp_collision_tree* tree, void* model_ptr, int version) {
     TRACE_SCOPE (tracing::ModelParseBSPTree);
@@ -760,7 +1023,8 @@ void model_collide_parse_bsp (
 
     ASSERT (chunk_type == OP_DEFPOINTS);
 
-    int n_verts = model_collide_parse_bsp_defpoints (p);
+    std::vector< vec3d* > point_list;
+    int n_verts = model_collide_parse_bsp_defpoints (&point_list, p);
 
     if (n_verts <= 0) {
         tree->point_list = NULL;
@@ -769,6 +1033,9 @@ void model_collide_parse_bsp (
         tree->n_nodes = 0;
         tree->node_list = NULL;
 
+        tree->n_wide_nodes = 0;
+        tree->wide_node_list = NULL;
+
         tree->n_leaves = 0;
         tree->leaf_list = NULL;
 
@@ -910,7 +1177,7 @@ void model_collide_parse_bsp (
     tree->point_list = (vec3d*)malloc (sizeof (vec3d) * n_verts);
 
     for (i = 0; i < (size_t)n_verts; ++i) {
-        tree->point_list[i] = *Mc_point_list[i];
+        tree->point_list[i] = *point_list[i];
     }
 
     tree->n_verts = n_verts;
@@ -923,6 +1190,18 @@ void model_collide_parse_bsp (
     memcpy (
         tree->node_list, &node_buffer[0],
         sizeof (bsp_collision_node) * node_buffer.size ());
+
+    // collapse the nodes into the wide tree the collision checks walk
+    std::vector< bsp_collision_wide_node > wide_node_buffer;
+    model_collide_build_wide_node (node_buffer, 0, &wide_node_buffer);
+
+    tree->n_wide_nodes = (int)wide_node_buffer.size ();
+    tree->wide_node_list = (bsp_collision_wide_node*)malloc (
+        sizeof (bsp_collision_wide_node) * wide_node_buffer.size ());
+    memcpy (
+        tree->wide_node_list, &wide_node_buffer[0],
+        sizeof (bsp_collision_wide_node) * wide_node_buffer.size ());
+
     node_buffer.clear ();
 
     // copy leaves.
@@ -943,26 +1222,28 @@ void model_collide_parse_bsp (
     vert_buffer.clear ();
 }
 
-bool mc_shield_check_common (shield_tri* tri) {
+bool mc_shield_check_common (mc_context* ctx, shield_tri* tri) {
+    mc_info* Mc = ctx->mc;
+
     vec3d* points[3];
     vec3d hitpoint;
 
     float dist;
     float sphere_check_closest_shield_dist = FLT_MAX;
 
-    // Check to see if Mc_pmly is facing away from ray.  If so, don't bother
+    // Check to see if poly is facing away from ray.  If so, don't bother
     // checking it.
-    if (vm_vec_dot (&Mc_direction, &tri->norm) > 0.0f) { return false; }
+    if (vm_vec_dot (&ctx->direction, &tri->norm) > 0.0f) { return false; }
     // get the vertices in the form the next function wants them
     for (int j = 0; j < 3; j++)
-        points[j] = &Mc_pm->shield.verts[tri->verts[j]].pos;
+        points[j] = &ctx->pm->shield.verts[tri->verts[j]].pos;
 
     if (!(Mc->flags & MC_CHECK_SPHERELINE)) { // Don't do this test for sphere
                                               // colliding against shields
-        // Find the intersection of this ray with the plane that the Mc_pmly
+        // Find the intersection of this ray with the plane that the poly
         // lies in
         dist = fvi_ray_plane (
-            NULL, points[0], &tri->norm, &Mc_p0, &Mc_direction, 0.0f);
+            NULL, points[0], &tri->norm, &ctx->p0, &ctx->direction, 0.0f);
 
         if (dist < 0.0f)
             return false; // If the ray is behind the plane there is no
@@ -970,15 +1251,15 @@ bool mc_shield_check_common (shield_tri* tri) {
         if (!(Mc->flags & MC_CHECK_RAY) && (dist > 1.0f))
             return false; // The ray isn't long enough to intersect the plane
 
-        // Find the hit Mc_pmint
-        vm_vec_scale_add (&hitpoint, &Mc_p0, &Mc_direction, dist);
+        // Find the hit point
+        vm_vec_scale_add (&hitpoint, &ctx->p0, &ctx->direction, dist);
 
-        // Check to see if the Mc_pmint of intersection is on the plane.  If
+        // Check to see if the point of intersection is on the plane.  If
         // so, this also finds the uv's where the ray hit.
         if (fvi_point_face (
                 &hitpoint, 3, points, &tri->norm, NULL, NULL, NULL)) {
             Mc->hit_dist = dist;
-            Mc->shield_hit_tri = (int)(tri - Mc_pm->shield.tris);
+            Mc->shield_hit_tri = (int)(tri - ctx->pm->shield.tris);
             Mc->hit_point = hitpoint;
             Mc->hit_normal = tri->norm;
             Mc->hit_submodel = -1;
@@ -993,12 +1274,12 @@ bool mc_shield_check_common (shield_tri* tri) {
         // HACK HACK!! The 10000.0 is the face radius, I didn't know this,
         // so I'm assume 10000 would be as big as ever.
         mc_check_sphereline_face (
-            3, points, points[0], &tri->norm, NULL, 0, NULL, NULL);
+            ctx, 3, points, points[0], &tri->norm, NULL, 0, NULL, NULL);
         if (Mc->num_hits && Mc->hit_dist < sphere_check_closest_shield_dist) {
             // same behavior whether face or edge
             // normal, edge_hit, hit_point all updated thru sphereline_face
             sphere_check_closest_shield_dist = Mc->hit_dist;
-            Mc->shield_hit_tri = (int)(tri - Mc_pm->shield.tris);
+            Mc->shield_hit_tri = (int)(tri - ctx->pm->shield.tris);
             Mc->hit_submodel = -1;
             Mc->num_hits++;
             return true; // We hit, so we're done
@@ -1008,48 +1289,48 @@ bool mc_shield_check_common (shield_tri* tri) {
     return false;
 }
 
-bool mc_check_sldc (int offset) {
-    if (offset > Mc_pm->sldc_size - 5) // no way is this big enough
+bool mc_check_sldc (mc_context* ctx, int offset) {
+    if (offset > ctx->pm->sldc_size - 5) // no way is this big enough
         return false;
-    char* type_p = (char*)(Mc_pm->shield_collision_tree + offset);
+    char* type_p = (char*)(ctx->pm->shield_collision_tree + offset);
 
     // not used
-    // int *size_p = (int *)(Mc_pm->shield_collision_tree+offset+1);
+    // int *size_p = (int *)(ctx->pm->shield_collision_tree+offset+1);
     // split and polygons
-    vec3d* minbox_p = (vec3d*)(Mc_pm->shield_collision_tree + offset + 5);
-    vec3d* maxbox_p = (vec3d*)(Mc_pm->shield_collision_tree + offset + 17);
+    vec3d* minbox_p = (vec3d*)(ctx->pm->shield_collision_tree + offset + 5);
+    vec3d* maxbox_p = (vec3d*)(ctx->pm->shield_collision_tree + offset + 17);
 
     // split
     unsigned int* front_offset_p =
-        (unsigned int*)(Mc_pm->shield_collision_tree + offset + 29);
+        (unsigned int*)(ctx->pm->shield_collision_tree + offset + 29);
     unsigned int* back_offset_p =
-        (unsigned int*)(Mc_pm->shield_collision_tree + offset + 33);
+        (unsigned int*)(ctx->pm->shield_collision_tree + offset + 33);
 
     // polygons
     unsigned int* num_polygons_p =
-        (unsigned int*)(Mc_pm->shield_collision_tree + offset + 29);
+        (unsigned int*)(ctx->pm->shield_collision_tree + offset + 29);
 
     unsigned int* shld_polys =
-        (unsigned int*)(Mc_pm->shield_collision_tree + offset + 33);
+        (unsigned int*)(ctx->pm->shield_collision_tree + offset + 33);
 
     // see if it fits inside our bbox
     if (!mc_ray_boundingbox (
-            minbox_p, maxbox_p, &Mc_p0, &Mc_direction, NULL)) {
+            ctx, minbox_p, maxbox_p, &ctx->p0, &ctx->direction, NULL)) {
         return false;
     }
 
     if (*type_p == 0) // SPLIT
     {
-        return mc_check_sldc (offset + *front_offset_p) ||
-               mc_check_sldc (offset + *back_offset_p);
+        return mc_check_sldc (ctx, offset + *front_offset_p) ||
+               mc_check_sldc (ctx, offset + *back_offset_p);
     }
     else {
         // poly list
         shield_tri* tri;
         for (unsigned int i = 0; i < *num_polygons_p; i++) {
-            tri = &Mc_pm->shield.tris[shld_polys[i]];
+            tri = &ctx->pm->shield.tris[shld_polys[i]];
 
-            mc_shield_check_common (tri);
+            mc_shield_check_common (ctx, tri);
 
         } // for (unsigned int i = 0; i < leaf->num_polygons; i++)
     }
@@ -1060,150 +1341,199 @@ bool mc_check_sldc (int offset) {
 
 // checks a vector collision against a ships shield (if it has shield points
 // defined).
-void mc_check_shield () {
+void mc_check_shield (mc_context* ctx) {
     int i;
 
-    if (Mc_pm->shield.ntris < 1) return;
-    if (Mc_pm->shield_collision_tree) {
-        mc_check_sldc (0); // see if we hit the SLDC
+    if (ctx->pm->shield.ntris < 1) return;
+    if (ctx->pm->shield_collision_tree) {
+        mc_check_sldc (ctx, 0); // see if we hit the SLDC
     }
     else {
         int o;
         for (o = 0; o < 8; o++) {
-            model_octant* poct1 = &Mc_pm->octants[o];
+            model_octant* poct1 = &ctx->pm->octants[o];
 
             if (!mc_ray_boundingbox (
-                    &poct1->min, &poct1->max, &Mc_p0, &Mc_direction, NULL)) {
+                    ctx, &poct1->min, &poct1->max, &ctx->p0,
+                    &ctx->direction, NULL)) {
                 continue;
             }
 
             for (i = 0; i < poct1->nshield_tris; i++) {
                 shield_tri* tri = poct1->shield_tris[i];
-                mc_shield_check_common (tri);
+                mc_shield_check_common (ctx, tri);
             }
         }
     } // model has shield_collsion_tree
 }
 
-// This function recursively checks a submodel and its children
-// for a collision with a vector.
-void mc_check_subobj (int mn) {
+// The index of the first ray of a packet
+static inline int mc_first_ray (uint rays) {
+    ASSERT (rays);
+
+    int k = 0;
+    while (!(rays & (1U << k))) { ++k; }
+
+    return k;
+}
+
+// Checks submodel mn and its children against the rays of the packet whose
+// bits are set in rays. All the rays share the model instance and the query
+// flags, so the children are instanced once for all of them.
+void mc_check_subobj (mc_context* ctxs, uint rays, int mn) {
+    mc_context* first = &ctxs[mc_first_ray (rays)];
+
+    polymodel* pm = first->pm;
+    int flags = first->mc->flags;
+
     vec3d tempv;
     vec3d hitpt; // used in bounding box check
     bsp_info* sm;
-    int i;
+    int i, k;
 
     ASSERT (mn >= 0);
-    ASSERT (mn < Mc_pm->n_models);
-    if ((mn < 0) || (mn >= Mc_pm->n_models)) return;
+    ASSERT (mn < pm->n_models);
+    if ((mn < 0) || (mn >= pm->n_models)) return;
 
-    sm = &Mc_pm->submodel[mn];
+    sm = &pm->submodel[mn];
     if (sm->no_collisions) return; // don't do collisions
-    if (sm->nocollide_this_only)
-        goto NoHit; // Don't collide for this model, but keep checking others
-
-    // Rotate the world check points into the current subobject's
-    // frame of reference.
-    // After this block, Mc_p0, Mc_p1, Mc_direction, and Mc_mag are correct
-    // and relative to this subobjects' frame of reference.
-    vm_vec_sub (&tempv, Mc->p0, &Mc_base);
-    vm_vec_rotate (&Mc_p0, &tempv, &Mc_orient);
-
-    vm_vec_sub (&tempv, Mc->p1, &Mc_base);
-    vm_vec_rotate (&Mc_p1, &tempv, &Mc_orient);
-    vm_vec_sub (&Mc_direction, &Mc_p1, &Mc_p0);
-
-    // bail early if no ray exists
-    if (IS_VEC_NULL (&Mc_direction)) { return; }
-
-    if (Mc_pm->detail[0] == mn) {
-        // Quickly bail if we aren't inside the full model bbox
-        if (!mc_ray_boundingbox (
-                &Mc_pm->mins, &Mc_pm->maxs, &Mc_p0, &Mc_direction, NULL)) {
-            return;
-        }
 
-        // If we are checking the root submodel, then we might want to check
-        // the shield at this point
-        if ((Mc->flags & MC_CHECK_SHIELD) && (Mc_pm->shield.ntris > 0)) {
-            mc_check_shield ();
-            return;
-        }
-    }
+    // The rays that go on to check the children of this submodel
+    uint child_rays = rays;
 
-    if (!(Mc->flags & MC_CHECK_MODEL)) { return; }
+    // Don't collide for this model, but keep checking others
+    if (!sm->nocollide_this_only) {
+        // The rays that hit the bounding box of this submodel
+        uint bsp_rays = 0;
 
-    Mc_submodel = mn;
+        for (k = 0; k < MC_PACKET_SIZE; ++k) {
+            if (!(rays & (1U << k))) { continue; }
 
-    // Check if the ray intersects this subobject's bounding box
-    if (mc_ray_boundingbox (
-            &sm->min, &sm->max, &Mc_p0, &Mc_direction, &hitpt)) {
-        if (Mc->flags & MC_ONLY_BOUND_BOX) {
-            float dist = vm_vec_dist (&Mc_p0, &hitpt);
+            mc_context* ctx = &ctxs[k];
+            mc_info* Mc = ctx->mc;
 
-            // If the ray is behind the plane there is no collision
-            if (dist < 0.0f) { goto NoHit; }
+            // Rotate the world check points into the current subobject's
+            // frame of reference.
+            // After this block, ctx->p0, ctx->p1, ctx->direction, and
+            // ctx->mag are correct
+            // and relative to this subobjects' frame of reference.
+            vm_vec_sub (&tempv, Mc->p0, &ctx->base);
+            vm_vec_rotate (&ctx->p0, &tempv, &ctx->orient);
 
-            // The ray isn't long enough to intersect the plane
-            if (!(Mc->flags & MC_CHECK_RAY) && (dist > Mc_mag)) { goto NoHit; }
+            vm_vec_sub (&tempv, Mc->p1, &ctx->base);
+            vm_vec_rotate (&ctx->p1, &tempv, &ctx->orient);
+            vm_vec_sub (&ctx->direction, &ctx->p1, &ctx->p0);
 
-            // If the ray hits, but a closer intersection has already been
-            // found, return
-            if (Mc->num_hits && (dist >= Mc->hit_dist)) { goto NoHit; }
+            // bail early if no ray exists
+            if (IS_VEC_NULL (&ctx->direction)) {
+                child_rays &= ~(1U << k);
+                continue;
+            }
 
-            Mc->hit_dist = dist;
-            Mc->hit_point = hitpt;
-            Mc->hit_submodel = Mc_submodel;
-            Mc->hit_bitmap = -1;
-            Mc->num_hits++;
+            if (pm->detail[0] == mn) {
+                // Quickly bail if we aren't inside the full model bbox
+                if (!mc_ray_boundingbox (
+                        ctx, &pm->mins, &pm->maxs, &ctx->p0,
+                        &ctx->direction, NULL)) {
+                    child_rays &= ~(1U << k);
+                    continue;
+                }
+
+                // If we are checking the root submodel, then we might want
+                // to check the shield at this point
+                if ((flags & MC_CHECK_SHIELD) && (pm->shield.ntris > 0)) {
+                    mc_check_shield (ctx);
+                    child_rays &= ~(1U << k);
+                    continue;
+                }
+            }
+
+            if (!(flags & MC_CHECK_MODEL)) {
+                child_rays &= ~(1U << k);
+                continue;
+            }
+
+            ctx->submodel = mn;
+
+            // Check if the ray intersects this subobject's bounding box
+            if (!mc_ray_boundingbox (
+                    ctx, &sm->min, &sm->max, &ctx->p0, &ctx->direction,
+                    &hitpt)) {
+                continue;
+            }
+
+            if (flags & MC_ONLY_BOUND_BOX) {
+                float dist = vm_vec_dist (&ctx->p0, &hitpt);
+
+                // If the ray is behind the plane there is no collision
+                if (dist < 0.0f) { continue; }
+
+                // The ray isn't long enough to intersect the plane
+                if (!(flags & MC_CHECK_RAY) && (dist > ctx->mag)) {
+                    continue;
+                }
+
+                // If the ray hits, but a closer intersection has already
+                // been found, return
+                if (Mc->num_hits && (dist >= Mc->hit_dist)) { continue; }
+
+                Mc->hit_dist = dist;
+                Mc->hit_point = hitpt;
+                Mc->hit_submodel = ctx->submodel;
+                Mc->hit_bitmap = -1;
+                Mc->num_hits++;
+            }
+            else {
+                bsp_rays |= 1U << k;
+            }
         }
-        else {
-            // The ray intersects this bounding box, so we have to check all
-            // the polygons in this submodel.
+
+        // The rays that intersect this bounding box have to check all the
+        // polygons in this submodel.
+        if (bsp_rays) {
             if (Cmdline_old_collision_sys) {
-                model_collide_sub (sm->bsp_data);
+                for (k = 0; k < MC_PACKET_SIZE; ++k) {
+                    if (bsp_rays & (1U << k)) {
+                        model_collide_sub (&ctxs[k], sm->bsp_data);
+                    }
+                }
             }
             else {
-                if (Mc->lod > 0 && sm->num_details > 0) {
-                    bsp_info* lod_sm = sm;
+                bsp_info* lod_sm = sm;
 
-                    for (i = Mc->lod - 1; i >= 0; i--) {
+                if (first->mc->lod > 0 && sm->num_details > 0) {
+                    for (i = first->mc->lod - 1; i >= 0; i--) {
                         if (sm->details[i] != -1) {
-                            lod_sm = &Mc_pm->submodel[sm->details[i]];
+                            lod_sm = &pm->submodel[sm->details[i]];
 
-                            // mprintf(("Checking %s collision for %s using %s
-                            // instead\n", Mc_pm->filename, sm->name,
+                            // mprintf(("Checking %s collision for %s using
+                            // %s instead\n", pm->filename, sm->name,
                             // lod_sm->name));
                             break;
                         }
                     }
-
-                    model_collide_bsp (
-                        model_get_bsp_collision_tree (
-                            lod_sm->collision_tree_index),
-                        0);
-                }
-                else {
-                    model_collide_bsp (
-                        model_get_bsp_collision_tree (
-                            sm->collision_tree_index),
-                        0);
                 }
+
+                model_collide_bsp (
+                    ctxs, bsp_rays,
+                    model_get_bsp_collision_tree (
+                        lod_sm->collision_tree_index));
             }
         }
     }
 
-NoHit:
-
     // If we're only checking one submodel, return
-    if (Mc->flags & MC_SUBMODEL) { return; }
+    if (flags & MC_SUBMODEL) { return; }
 
     // If this subobject doesn't have any children, we're done checking it.
-    if (sm->num_children < 1) return;
+    if (sm->num_children < 1 || !child_rays) return;
+
+    // Save instance (ctx->orient, ctx->base, Mc_point_base), which is the same
+    // for all the rays
+    matrix saved_orient = first->orient;
+    vec3d saved_base = first->base;
 
-    // Save instance (Mc_orient, Mc_base, Mc_point_base)
-    matrix saved_orient = Mc_orient;
-    vec3d saved_base = Mc_base;
+    polymodel_instance* pmi = first->pmi;
 
     // Check all of this subobject's children
     i = sm->first_child;
@@ -1211,12 +1541,12 @@ NoHit:
         angles_t angs;
         bool blown_off;
         bool collision_checked;
-        bsp_info* csm = &Mc_pm->submodel[i];
+        bsp_info* csm = &pm->submodel[i];
 
-        if (Mc_pmi) {
-            angs = Mc_pmi->submodel[i].angs;
-            blown_off = Mc_pmi->submodel[i].blown_off;
-            collision_checked = Mc_pmi->submodel[i].collision_checked;
+        if (pmi) {
+            angs = pmi->submodel[i].angs;
+            blown_off = pmi->submodel[i].blown_off;
+            collision_checked = pmi->submodel[i].collision_checked;
         }
         else {
             angs = csm->angs;
@@ -1227,17 +1557,20 @@ NoHit:
         // Don't check it or its children if it is destroyed
         // or if it's set to no collision
         if (!blown_off && !collision_checked && !csm->no_collisions) {
-            if (Mc_pmi) {
-                Mc_orient = Mc_pmi->submodel[i].mc_orient;
-                Mc_base = Mc_pmi->submodel[i].mc_base;
-                vm_vec_add2 (&Mc_base, Mc->pos);
+            matrix orient;
+            vec3d base;
+
+            if (pmi) {
+                orient = pmi->submodel[i].mc_orient;
+                base = pmi->submodel[i].mc_base;
+                vm_vec_add2 (&base, first->mc->pos);
             }
             else {
                 // instance for this subobject
                 matrix tm = IDENTITY_MATRIX;
 
-                vm_vec_unrotate (&Mc_base, &csm->offset, &saved_orient);
-                vm_vec_add2 (&Mc_base, &saved_base);
+                vm_vec_unrotate (&base, &csm->offset, &saved_orient);
+                vm_vec_add2 (&base, &saved_base);
 
                 if (vm_matrix_same (&tm, &csm->orientation)) {
                     // if submodel orientation matrix is identity matrix then
@@ -1255,10 +1588,17 @@ NoHit:
                         &tm, &rotation_matrix, &inv_orientation);
                 }
 
-                vm_matrix_x_matrix (&Mc_orient, &saved_orient, &tm);
+                vm_matrix_x_matrix (&orient, &saved_orient, &tm);
+            }
+
+            for (k = 0; k < MC_PACKET_SIZE; ++k) {
+                if (child_rays & (1U << k)) {
+                    ctxs[k].orient = orient;
+                    ctxs[k].base = base;
+                }
             }
 
-            mc_check_subobj (i);
+            mc_check_subobj (ctxs, child_rays, i);
         }
 
         i = csm->next_sibling;
@@ -1267,11 +1607,10 @@ NoHit:
 
 MONITOR (NumFVI)
 
-// See model.h for usage.   I don't want to put the
-// usage here because you need to see the #defines and structures
-// this uses while reading the help.
-int model_collide (mc_info* mc_info_obj) {
-    Mc = mc_info_obj;
+// Sets up the context of a query and checks its bounding sphere. Returns true
+// if the query goes on to check the submodels.
+static bool mc_collide_begin (mc_context* ctx, mc_info* mc_info_obj) {
+    mc_info* Mc = ctx->mc = mc_info_obj;
 
     MONITOR_INC (NumFVI, 1);
 
@@ -1282,27 +1621,29 @@ int model_collide (mc_info* mc_info_obj) {
 
     if ((Mc->flags & MC_CHECK_SHIELD) && (Mc->flags & MC_CHECK_MODEL)) {
         ASSERTX (0, "Checking both shield and model!\n");
-        return 0;
+        return false;
     }
 
-    // Fill in some global variables that all the model collide routines need
+    // Fill in the query context that all the model collide routines need
     // internally.
-    Mc_pm = model_get (Mc->model_num);
-    Mc_orient = *Mc->orient;
-    Mc_base = *Mc->pos;
-    Mc_mag = vm_vec_dist (Mc->p0, Mc->p1);
-    Mc_edge_time = FLT_MAX;
+    ctx->pm = model_get (Mc->model_num);
+    ctx->orient = *Mc->orient;
+    ctx->base = *Mc->pos;
+    ctx->mag = vm_vec_dist (Mc->p0, Mc->p1);
+    ctx->edge_time = FLT_MAX;
+    ctx->submodel = -1;
+    ctx->point_list = mc_get_point_list ().data ();
 
     if (Mc->model_instance_num >= 0) {
-        Mc_pmi = model_get_instance (Mc->model_instance_num);
+        ctx->pmi = model_get_instance (Mc->model_instance_num);
     }
     else {
-        Mc_pmi = NULL;
+        ctx->pmi = NULL;
     }
 
     // DA 11/19/98 - disable this check for rotating submodels
     // Don't do check if for very small movement
-    // if (Mc_mag < 0.01f) {
+    // if (ctx->mag < 0.01f) {
     // return 0;
     // }
 
@@ -1312,17 +1653,17 @@ int model_collide (mc_info* mc_info_obj) {
 
     if ((Mc->flags & MC_SUBMODEL) || (Mc->flags & MC_SUBMODEL_INSTANCE)) {
         first_submodel = Mc->submodel_num;
-        model_radius = Mc_pm->submodel[first_submodel].rad;
+        model_radius = ctx->pm->submodel[first_submodel].rad;
     }
     else {
-        first_submodel = Mc_pm->detail[0];
-        model_radius = Mc_pm->rad;
+        first_submodel = ctx->pm->detail[0];
+        model_radius = ctx->pm->rad;
     }
 
     if (Mc->flags & MC_CHECK_SPHERELINE) {
         if (Mc->radius <= 0.0f) {
-            WARNINGF (LOCATION,"Attempting to collide with a sphere, but the sphere's radius is <= 0.0f!\n\n(model file is %s; submodel is %d, mc_flags are %d)",Mc_pm->filename, first_submodel, Mc->flags);
-            return 0;
+            WARNINGF (LOCATION,"Attempting to collide with a sphere, but the sphere's radius is <= 0.0f!\n\n(model file is %s; submodel is %d, mc_flags are %d)",ctx->pm->filename, first_submodel, Mc->flags);
+            return false;
         }
 
         // Do a quick check on the Bounding Sphere
@@ -1333,12 +1674,12 @@ int model_collide (mc_info* mc_info_obj) {
                 Mc->hit_point = Mc->hit_point_world;
                 Mc->hit_submodel = first_submodel;
                 Mc->num_hits++;
-                return (Mc->num_hits > 0);
+                return false;
             }
             // continue checking polygons.
         }
         else {
-            return 0;
+            return false;
         }
     }
     else {
@@ -1358,32 +1699,46 @@ int model_collide (mc_info* mc_info_obj) {
                 Mc->hit_point = Mc->hit_point_world;
                 Mc->hit_submodel = first_submodel;
                 Mc->num_hits++;
-                return (Mc->num_hits > 0);
+                return false;
             }
             // continue checking polygons.
         }
         else {
-            return 0;
+            return false;
         }
     }
 
+    return true;
+}
+
+// Checks the submodels against the rays of the packet whose bits are set in
+// rays
+static void mc_collide_submodels (mc_context* ctxs, uint rays) {
+    mc_context* ctx = &ctxs[mc_first_ray (rays)];
+    mc_info* Mc = ctx->mc;
+
     if (Mc->flags & MC_SUBMODEL) {
         // Check only one subobject
-        mc_check_subobj (Mc->submodel_num);
+        mc_check_subobj (ctxs, rays, Mc->submodel_num);
         // Check submodel and any children
     }
     else if (Mc->flags & MC_SUBMODEL_INSTANCE) {
-        mc_check_subobj (Mc->submodel_num);
+        mc_check_subobj (ctxs, rays, Mc->submodel_num);
     }
     else {
         // Check all the the highest detail model polygons and subobjects for
         // intersections
 
         // Don't check it or its children if it is destroyed
-        if (!Mc_pm->submodel[Mc_pm->detail[0]].blown_off) {
-            mc_check_subobj (Mc_pm->detail[0]);
+        if (!ctx->pm->submodel[ctx->pm->detail[0]].blown_off) {
+            mc_check_subobj (ctxs, rays, ctx->pm->detail[0]);
         }
     }
+}
+
+// Rotates the hit of a query, if any, into world coordinates
+static void mc_collide_end (mc_context* ctx) {
+    mc_info* Mc = ctx->mc;
 
     // If we found a hit, then rotate it into world coordinates
     if (Mc->num_hits) {
@@ -1394,7 +1749,7 @@ int model_collide (mc_info* mc_info_obj) {
             vm_vec_add2 (&Mc->hit_point_world, Mc->pos);
         }
         else {
-            if (Mc_pmi) {
+            if (ctx->pmi) {
                 model_instance_find_world_point (
                     &Mc->hit_point_world, &Mc->hit_point,
                     Mc->model_instance_num, Mc->hit_submodel, Mc->orient,
@@ -1407,8 +1762,58 @@ int model_collide (mc_info* mc_info_obj) {
             }
         }
     }
+}
 
-    return Mc->num_hits;
+// See model.h for usage.   I don't want to put the
+// usage here because you need to see the #defines and structures
+// this uses while reading the help.
+int model_collide (mc_info* mc_info_obj) {
+    mc_context ctx;
+
+    if (mc_collide_begin (&ctx, mc_info_obj)) {
+        mc_collide_submodels (&ctx, 1);
+        mc_collide_end (&ctx);
+    }
+
+    return mc_info_obj->num_hits;
+}
+
+int model_collide_packet (mc_info* mc_list, int count) {
+    int hits = 0;
+
+    for (int first = 0; first < count; first += MC_PACKET_SIZE) {
+        mc_context ctxs[MC_PACKET_SIZE];
+
+        int n = (std::min) (count - first, MC_PACKET_SIZE);
+        uint rays = 0;
+
+        for (int k = 0; k < n; ++k) {
+            mc_info* Mc = &mc_list[first + k];
+
+            // the traversal is shared, so must be everything but the rays
+            ASSERT (Mc->model_num == mc_list[0].model_num);
+            ASSERT (Mc->model_instance_num == mc_list[0].model_instance_num);
+            ASSERT (Mc->submodel_num == mc_list[0].submodel_num);
+            ASSERT (Mc->flags == mc_list[0].flags);
+            ASSERT (Mc->lod == mc_list[0].lod);
+
+            if (mc_collide_begin (&ctxs[k], Mc)) { rays |= 1U << k; }
+        }
+
+        if (rays) {
+            mc_collide_submodels (ctxs, rays);
+
+            for (int k = 0; k < n; ++k) {
+                if (rays & (1U << k)) { mc_collide_end (&ctxs[k]); }
+            }
+        }
+
+        for (int k = 0; k < n; ++k) {
+            if (mc_list[first + k].num_hits) { ++hits; }
+        }
+    }
+
+    return hits;
 }
 
 void model_collide_preprocess_subobj (
@@ -1471,3 +1876,142 @@ void model_collide_preprocess (
     model_collide_preprocess_subobj (
         &current_pos, &current_orient, pm, pmi, pm->detail[detail_num]);
 }
+
+//
+// Fires the same set of rays at a model from several threads at once and
+// compares the results with a single-threaded run.
+//
+struct mc_stress_ray {
+    vec3d p0, p1;
+
+    int num_hits;
+    int hit_submodel;
+    float hit_dist;
+};
+
+static void mc_stress_fire (
+    int model_num, std::vector< mc_stress_ray >& rays, size_t first,
+    size_t last) {
+    for (size_t i = first; i < last; ++i) {
+        mc_stress_ray& ray = rays[i];
+
+        mc_info mc;
+        mc_info_init (&mc);
+
+        mc.model_num = model_num;
+        mc.orient = &vmd_identity_matrix;
+        mc.pos = &vmd_zero_vector;
+        mc.p0 = &ray.p0;
+        mc.p1 = &ray.p1;
+        mc.flags = MC_CHECK_MODEL;
+
+        model_collide (&mc);
+
+        ray.num_hits = mc.num_hits;
+        ray.hit_submodel = mc.num_hits ? mc.hit_submodel : -1;
+        ray.hit_dist = mc.num_hits ? mc.hit_dist : 0.0f;
+    }
+}
+
+DCF (model_collide_stress, "Fires rays at a model from several threads") {
+    if (dc_optional_string_either ("help", "--help")) {
+        dc_printf ("Usage: model_collide_stress <model> [threads] [rays]\n");
+        dc_printf (
+            "Fires <rays> rays (default 100000) at <model> (e.g., "
+            "capital2t-01.pof)\nsplit over [threads] threads (default 4), "
+            "and checks the hits against a\nsingle-threaded run.\n");
+        return;
+    }
+
+    std::string filename;
+    dc_stuff_string_white (filename);
+
+    int n_threads = 4, n_rays = 100000;
+
+    dc_maybe_stuff_int (&n_threads);
+    dc_maybe_stuff_int (&n_rays);
+
+    if (n_threads < 1 || n_rays < 1) {
+        dc_printf ("Thread and ray counts must be positive\n");
+        return;
+    }
+
+    int model_num = model_load (filename.c_str (), 0, NULL, 0);
+
+    if (model_num < 0) {
+        dc_printf ("Unable to load model %s\n", filename.c_str ());
+        return;
+    }
+
+    polymodel* pm = model_get (model_num);
+
+    // Aim from a sphere around the model at random points in its bounding
+    // box; a fixed seed keeps the runs comparable
+    std::vector< mc_stress_ray > rays (n_rays);
+    uint seed = 0x2545F491;
+
+    auto frand = [&seed]() {
+        seed = seed * 1664525 + 1013904223;
+        return float (seed >> 8) / float (1 << 24);
+    };
+
+    for (auto& ray : rays) {
+        vec3d dir = { { { frand () - 0.5f, frand () - 0.5f,
+                          frand () - 0.5f } } };
+
+        if (IS_VEC_NULL (&dir)) { dir.xyz.z = 1.0f; }
+
+        vm_vec_normalize (&dir);
+        vm_vec_copy_scale (&ray.p0, &dir, pm->rad * 2.0f);
+
+        for (int axis = 0; axis < 3; ++axis) {
+            ray.p1.a1d[axis] = pm->mins.a1d[axis] +
+                               frand () * (pm->maxs.a1d[axis] -
+                                           pm->mins.a1d[axis]);
+        }
+    }
+
+    std::vector< mc_stress_ray > expected = rays;
+
+    std::uint64_t start = timer_get_nanoseconds ();
+    mc_stress_fire (model_num, expected, 0, expected.size ());
+    std::uint64_t serial = timer_get_nanoseconds () - start;
+
+    std::vector< std::thread > threads;
+    size_t chunk = (rays.size () + n_threads - 1) / n_threads;
+
+    start = timer_get_nanoseconds ();
+
+    for (size_t first = 0; first < rays.size (); first += chunk) {
+        size_t last = (std::min) (first + chunk, rays.size ());
+
+        threads.emplace_back (
+            mc_stress_fire, model_num, std::ref (rays), first, last);
+    }
+
+    for (auto& thread : threads) { thread.join (); }
+
+    std::uint64_t parallel = timer_get_nanoseconds () - start;
+
+    int hits = 0, mismatches = 0;
+
+    for (size_t i = 0; i < rays.size (); ++i) {
+        if (expected[i].num_hits) { ++hits; }
+
+        if (rays[i].num_hits != expected[i].num_hits ||
+            rays[i].hit_submodel != expected[i].hit_submodel ||
+            rays[i].hit_dist != expected[i].hit_dist) {
+            ++mismatches;
+        }
+    }
+
+    dc_printf (
+        "%s: %d rays, %d hits, %d mismatches\n", pm->filename, n_rays, hits,
+        mismatches);
+    dc_printf (
+        "  1 thread: %.1f ms (%.0f rays/s)\n", serial / 1e6,
+        n_rays / (serial / 1e9));
+    dc_printf (
+        "  %d threads: %.1f ms (%.0f rays/s)\n", int (threads.size ()),
+        parallel / 1e6, n_rays / (parallel / 1e9));
+}
@@ -28,6 +28,7 @@
 #include "parse/parselo.hh"
 #include "render/3dinternal.hh"
 #include "ship/ship.hh"
+#include "tracing/MemoryAccount.hh"
 #include "tracing/tracing.hh"
 #include "util/list.hh"
 #include "util/strings.hh"
@@ -76,6 +77,24 @@ static uint Global_checksum = 0;
 
 static int Model_signature = 0;
 
+static tracing::MemoryAccount Model_memory ("Models");
+
+// The bytes held by a loaded model: the structures and the data read from the
+// model file, but not the vertex buffers which are freed once uploaded
+static size_t model_memory_size (const polymodel* pm) {
+    size_t size = sizeof (polymodel) + pm->n_models * sizeof (bsp_info);
+
+    for (int i = 0; i < pm->n_models; ++i) {
+        size += pm->submodel[i].bsp_data_size;
+    }
+
+    size += pm->sldc_size + pm->debug_info_size;
+    size += pm->shield.nverts * sizeof (shield_vertex);
+    size += pm->shield.ntris * sizeof (shield_tri);
+
+    return size;
+}
+
 void interp_configure_vertex_buffers (polymodel*, int);
 void interp_pack_vertex_buffers (polymodel* pm, int mn);
 void interp_create_detail_index_buffer (polymodel* pm, int detail);
@@ -161,6 +180,8 @@ void model_unload (int modelnum, int force) {
 
     WARNINGF (LOCATION, "Unloading model '%s' from slot '%i'", pm->filename, num);
 
+    Model_memory.remove (model_memory_size (pm));
+
     // so that the textures can be released
     pm->used_this_mission = 0;
 
@@ -2983,6 +3004,8 @@ int model_load (
     model_set_subsys_path_nums (pm, n_subsystems, subsystems);
     model_set_bay_path_nums (pm);
 
+    Model_memory.add (model_memory_size (pm));
+
     return pm->id;
 }
 
@@ -5407,6 +5430,10 @@ void model_remove_bsp_collision_tree (int tree_index) {
         free (Bsp_collision_tree_list[tree_index].node_list);
     }
 
+    if (Bsp_collision_tree_list[tree_index].wide_node_list) {
+        free (Bsp_collision_tree_list[tree_index].wide_node_list);
+    }
+
     if (Bsp_collision_tree_list[tree_index].leaf_list) {
         free (Bsp_collision_tree_list[tree_index].leaf_list);
     }
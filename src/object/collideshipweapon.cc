@@ -129,67 +129,45 @@ static void ship_weapon_do_hit_stuff (
 
 extern int Framecount;
 
-static int ship_weapon_check_collision (
-    object* ship_objp, object* weapon_objp, float time_limit = 0.0f,
-    int* next_hit = NULL) {
-    mc_info mc, mc_shield, mc_hull;
-    ship* shipp;
-    ship_info* sip;
-    weapon* wp;
-    weapon_info* wip;
-
-    ASSERT (ship_objp != NULL);
-    ASSERT (ship_objp->type == OBJ_SHIP);
-    ASSERT (ship_objp->instance >= 0);
-
-    shipp = &Ships[ship_objp->instance];
-    sip = &Ship_info[shipp->ship_info_index];
-
-    ASSERT (weapon_objp != NULL);
-    ASSERT (weapon_objp->type == OBJ_WEAPON);
-    ASSERT (weapon_objp->instance >= 0);
-
-    wp = &Weapons[weapon_objp->instance];
-    wip = &Weapon_info[wp->weapon_info_index];
-
-    ASSERT (shipp->objnum == OBJ_INDEX (ship_objp));
-
-    // Make ships that are warping in not get collision detection done
-    if (shipp->is_arriving ()) return 0;
-
-    // Return information for AI to detect incoming fire.
-    // Could perhaps be done elsewhere at lower cost --MK, 11/7/97
-    float dist = vm_vec_dist_quick (&ship_objp->pos, &weapon_objp->pos);
-    if (dist < weapon_objp->phys_info.speed) {
-        update_danger_weapon (ship_objp, weapon_objp);
-    }
-
-    int valid_hit_occurred = 0; // If this is set, then hitpos is set
-    int quadrant_num = -1;
+//
+// The geometric part of the ship:weapon check.  Casts the weapon path against
+// the shield and the hull of the ship and records both results in the test;
+// reads the game state but never changes it.
+//
+static void ship_weapon_test_collision (
+    object* ship_objp, object* weapon_objp, float time_limit,
+    ship_weapon_test* test) {
+    ship* shipp = &Ships[ship_objp->instance];
+    ship_info* sip = &Ship_info[shipp->ship_info_index];
+    weapon* wp = &Weapons[weapon_objp->instance];
     polymodel* pm = model_get (sip->model_num);
 
+    // the collision structs point at the end position, so it lives in the
+    // test along with them
+    mc_info& mc_shield = test->mc_shield;
+    mc_info& mc_hull = test->mc_hull;
+    vec3d& weapon_end_pos = test->weapon_end_pos;
+
     // total time is flFrametime + time_limit (time_limit used to predict
     // collisions into the future)
-    vec3d weapon_end_pos;
     vm_vec_scale_add (
         &weapon_end_pos, &weapon_objp->pos, &weapon_objp->phys_info.vel,
         time_limit);
 
     // Goober5000 - I tried to make collision code here much saner... here
     // begin the (major) changes
-    mc_info_init (&mc);
+    mc_info_init (&mc_shield);
 
     // set up collision structs
-    mc.model_instance_num = shipp->model_instance_num;
-    mc.model_num = sip->model_num;
-    mc.submodel_num = -1;
-    mc.orient = &ship_objp->orient;
-    mc.pos = &ship_objp->pos;
-    mc.p0 = &weapon_objp->last_pos;
-    mc.p1 = &weapon_end_pos;
-    mc.lod = sip->collision_lod;
-    memcpy (&mc_shield, &mc, sizeof (mc_info));
-    memcpy (&mc_hull, &mc, sizeof (mc_info));
+    mc_shield.model_instance_num = shipp->model_instance_num;
+    mc_shield.model_num = sip->model_num;
+    mc_shield.submodel_num = -1;
+    mc_shield.orient = &ship_objp->orient;
+    mc_shield.pos = &ship_objp->pos;
+    mc_shield.p0 = &weapon_objp->last_pos;
+    mc_shield.p1 = &weapon_end_pos;
+    mc_shield.lod = sip->collision_lod;
+    memcpy (&mc_hull, &mc_shield, sizeof (mc_info));
 
     // (btw, these are leftover comments from below...)
     //
@@ -380,6 +358,65 @@ static int ship_weapon_check_collision (
         hull_collision = model_collide (&mc_hull);
     }
 
+    test->shield_collision = shield_collision;
+    test->hull_collision = hull_collision;
+    test->done = true;
+}
+
+static int ship_weapon_check_collision (
+    object* ship_objp, object* weapon_objp, float time_limit = 0.0f,
+    int* next_hit = NULL, const ship_weapon_test* test = NULL) {
+    mc_info mc;
+    ship* shipp;
+    ship_info* sip;
+    weapon* wp;
+    weapon_info* wip;
+
+    ASSERT (ship_objp != NULL);
+    ASSERT (ship_objp->type == OBJ_SHIP);
+    ASSERT (ship_objp->instance >= 0);
+
+    shipp = &Ships[ship_objp->instance];
+    sip = &Ship_info[shipp->ship_info_index];
+
+    ASSERT (weapon_objp != NULL);
+    ASSERT (weapon_objp->type == OBJ_WEAPON);
+    ASSERT (weapon_objp->instance >= 0);
+
+    wp = &Weapons[weapon_objp->instance];
+    wip = &Weapon_info[wp->weapon_info_index];
+
+    ASSERT (shipp->objnum == OBJ_INDEX (ship_objp));
+
+    // Make ships that are warping in not get collision detection done
+    if (shipp->is_arriving ()) return 0;
+
+    // Return information for AI to detect incoming fire.
+    // Could perhaps be done elsewhere at lower cost --MK, 11/7/97
+    float dist = vm_vec_dist_quick (&ship_objp->pos, &weapon_objp->pos);
+    if (dist < weapon_objp->phys_info.speed) {
+        update_danger_weapon (ship_objp, weapon_objp);
+    }
+
+    int valid_hit_occurred = 0; // If this is set, then hitpos is set
+    int quadrant_num = -1;
+
+    ship_weapon_test local_test;
+
+    if (!test || !test->done || time_limit != 0.0f) {
+        ship_weapon_test_collision (
+            ship_objp, weapon_objp, time_limit, &local_test);
+        test = &local_test;
+    }
+
+    mc_info mc_shield = test->mc_shield;
+    mc_info mc_hull = test->mc_hull;
+
+    int shield_collision = test->shield_collision;
+    int hull_collision = test->hull_collision;
+
+    mc_info_init (&mc);
+
     if (shield_collision) {
         // pick out the shield quadrant
         quadrant_num = get_quadrant (&mc_shield.hit_point, ship_objp);
@@ -491,6 +528,35 @@ static int ship_weapon_check_collision (
     return valid_hit_occurred;
 }
 
+/**
+ * Cull lasers within big ship spheres by casting a vector forward for (1)
+ * exit sphere or (2) lifetime of laser If it does hit, don't check the pair
+ * until about 200 ms before collision. If it does not hit and is within error
+ * tolerance, cull the pair.
+ * @return true if the pair goes through check_inside_radius_for_big_ships
+ */
+static bool ship_weapon_inside_big_ship (object* ship, object* weapon_obj) {
+    ship_info* sip = &Ship_info[Ships[ship->instance].ship_info_index];
+
+    if ((sip->is_big_or_huge ()) &&
+        (Weapon_info[Weapons[weapon_obj->instance].weapon_info_index]
+             .subtype == WP_LASER)) {
+        // Check when within ~1.1 radii.
+        // This allows good transition between sphere checking (leaving the
+        // laser about 200 ms from radius) and checking within the sphere with
+        // little time between.  There may be some time for "small" big ships
+        // Note: culling ships with auto spread shields seems to waste more
+        // performance than it saves, so we're not doing that here
+        if (!(sip->flags[Ship::Info_Flags::Auto_spread_shields]) &&
+            vm_vec_dist_squared (&ship->pos, &weapon_obj->pos) <
+                (1.2f * ship->radius * ship->radius)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 /**
  * Checks ship-weapon collisions.
  * @param pair obj_pair pointer to the two objects. pair->a is ship and pair->b
@@ -505,8 +571,6 @@ int collide_ship_weapon (obj_pair* pair) {
     ASSERT (ship->type == OBJ_SHIP);
     ASSERT (weapon_obj->type == OBJ_WEAPON);
 
-    ship_info* sip = &Ship_info[Ships[ship->instance].ship_info_index];
-
     // Don't check collisions for player if past first warpout stage.
     if (Player->control_mode > PCM_WARPOUT_STAGE1) {
         if (ship == Player_obj) return 0;
@@ -514,28 +578,12 @@ int collide_ship_weapon (obj_pair* pair) {
 
     if (reject_due_collision_groups (ship, weapon_obj)) return 0;
 
-    // Cull lasers within big ship spheres by casting a vector forward for (1)
-    // exit sphere or (2) lifetime of laser If it does hit, don't check the
-    // pair until about 200 ms before collision. If it does not hit and is
-    // within error tolerance, cull the pair.
-
-    if ((sip->is_big_or_huge ()) &&
-        (Weapon_info[Weapons[weapon_obj->instance].weapon_info_index]
-             .subtype == WP_LASER)) {
-        // Check when within ~1.1 radii.
-        // This allows good transition between sphere checking (leaving the
-        // laser about 200 ms from radius) and checking within the sphere with
-        // little time between.  There may be some time for "small" big ships
-        // Note: culling ships with auto spread shields seems to waste more
-        // performance than it saves, so we're not doing that here
-        if (!(sip->flags[Ship::Info_Flags::Auto_spread_shields]) &&
-            vm_vec_dist_squared (&ship->pos, &weapon_obj->pos) <
-                (1.2f * ship->radius * ship->radius)) {
-            return check_inside_radius_for_big_ships (ship, weapon_obj, pair);
-        }
+    if (ship_weapon_inside_big_ship (ship, weapon_obj)) {
+        return check_inside_radius_for_big_ships (ship, weapon_obj, pair);
     }
 
-    did_hit = ship_weapon_check_collision (ship, weapon_obj);
+    did_hit = ship_weapon_check_collision (
+        ship, weapon_obj, 0.0f, NULL, pair->test);
 
     if (!did_hit) {
         // Since we didn't hit, check to see if we can disable all future
@@ -546,6 +594,33 @@ int collide_ship_weapon (obj_pair* pair) {
     return 0;
 }
 
+void collide_ship_weapon_test (obj_pair* pair, ship_weapon_test* test) {
+    object* ship = pair->a;
+    object* weapon_obj = pair->b;
+
+    ASSERT (ship->type == OBJ_SHIP);
+    ASSERT (weapon_obj->type == OBJ_WEAPON);
+
+    test->done = false;
+
+    // the same early outs as collide_ship_weapon, anything that does not end
+    // up in the plain check is left to the serial stage
+    if (Player->control_mode > PCM_WARPOUT_STAGE1 && ship == Player_obj) {
+        return;
+    }
+
+    if (reject_due_collision_groups (ship, weapon_obj)) return;
+
+    if (ship_weapon_inside_big_ship (ship, weapon_obj)) return;
+
+    if (Ships[ship->instance].is_arriving ()) return;
+
+    ship_weapon_test_collision (ship, weapon_obj, 0.0f, test);
+
+    test->ship_pos = ship->pos;
+    test->ship_orient = ship->orient;
+}
+
 /**
  * Upper limit estimate ship speed at end of time
  */
@@ -1,6 +1,10 @@
 // -*- mode: c++; -*-
 
 #include "defs.hh"
+
+#include <algorithm>
+#include <cstring>
+
 #include "util/list.hh"
 #include "io/timer.hh"
 #include "object/objcollide.hh"
@@ -11,6 +15,7 @@
 #include "weapon/beam.hh"
 #include "weapon/weapon.hh"
 #include "tracing/Monitor.hh"
+#include "util/ThreadPool.hh"
 #include "log/log.hh"
 
 //#define MAX_PAIRS 10000       // Bumped back to 10,000 by WMC
@@ -36,25 +41,220 @@ obj_pair* Obj_pairs = NULL;
 obj_pair pair_used_list;
 obj_pair pair_free_list;
 
-std::vector< int > Collision_sort_list;
+//
+// Persistent sweep-and-prune state. Every collider has its bounds cached in
+// Collider_bounds, refreshed once per frame, and one endpoint in each of the
+// per-axis lists, which stay nearly sorted from one frame to the next.
+//
+struct collider_bounds {
+    vec3d min;
+    vec3d max;
+};
+
+struct sap_endpoint {
+    float min;
+    float max;
+    int objnum;
+};
+
+#define COLLIDER_MEMBER (1 << 0) // object is a collider
+#define COLLIDER_LISTED (1 << 1) // object has endpoints in the axis lists
 
-class collider_pair {
-public:
-    object* a;
-    object* b;
-    int signature_a;
-    int signature_b;
+// marks a collider that was removed while the sweep is in progress
+#define COLLIDER_PASS_NONE 0xFF
+
+static collider_bounds Collider_bounds[MAX_OBJECTS];
+static std::vector< sap_endpoint > Collider_axis[3];
+
+static ubyte Collider_state[MAX_OBJECTS];
+
+// number of axes on which a collider overlapped another one this frame
+static ubyte Collider_pass[MAX_OBJECTS];
+
+static size_t Colliders_added = 0;
+static size_t Colliders_removed = 0;
+
+//
+// Cached check times of object pairs, in an open addressing table keyed by the
+// signatures of both objects. Signatures are not reused within a mission, so
+// an entry never refers to a newer pair of objects. Pairs that were not seen
+// in this or the previous frame are stale: new pairs take over their slots and
+// they are dropped when the table is rebuilt.
+//
+struct collider_pair {
+    std::uint64_t key; // signatures of both objects, 0 for an empty slot
     int next_check_time;
-    bool initialized;
+    uint frame; // Collision_cache_frame when last seen, 0 if evicted
+    short a;
+    short b;
+};
+
+static std::vector< collider_pair > Collision_cached_pairs;
+static size_t Collision_cached_used = 0; // slots that are not empty
+static uint Collision_cache_frame = 2;
+
+#define MIN_CACHED_PAIRS 1024
+
+static inline std::uint64_t collider_pair_key (object* A, object* B) {
+    return (std::uint64_t (uint (A->signature)) << 32) | uint (B->signature);
+}
+
+static inline size_t collider_pair_hash (std::uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return size_t (key);
+}
+
+static inline bool collider_pair_stale (const collider_pair& pair) {
+    return pair.frame + 1 < Collision_cache_frame;
+}
+
+static inline bool collider_pair_valid (const collider_pair& pair) {
+    return Objects[pair.a].signature == int (pair.key >> 32) &&
+           Objects[pair.b].signature == int (pair.key & 0xFFFFFFFF);
+}
+
+//
+// Moves the pairs that are not stale to a table sized for four times their
+// number, and forgets the rest.
+//
+static void collider_pair_rebuild () {
+    size_t live = 0;
+
+    for (const auto& pair : Collision_cached_pairs) {
+        if (pair.key && !collider_pair_stale (pair)) { ++live; }
+    }
+
+    size_t size = MIN_CACHED_PAIRS;
+    while (size < live * 4) { size *= 2; }
+
+    std::vector< collider_pair > table (size, collider_pair{ });
+
+    for (const auto& pair : Collision_cached_pairs) {
+        if (!pair.key || collider_pair_stale (pair)) { continue; }
+
+        size_t i = collider_pair_hash (pair.key);
+        while (table[i & (size - 1)].key) { ++i; }
+
+        table[i & (size - 1)] = pair;
+    }
 
-    // we need to define a constructor because the hash map can
-    // implicitly insert an object when we use the [] operator
-    collider_pair ()
-        : a (NULL), b (NULL), signature_a (-1), signature_b (-1),
-          next_check_time (-1), initialized (false) {}
+    Collision_cached_pairs.swap (table);
+    Collision_cached_used = live;
+}
+
+// Returns the entry of a pair, or NULL if the pair is not cached
+static collider_pair* collider_pair_find (std::uint64_t key) {
+    if (Collision_cached_pairs.empty ()) { return NULL; }
+
+    const size_t mask = Collision_cached_pairs.size () - 1;
+
+    for (size_t i = collider_pair_hash (key);; ++i) {
+        collider_pair& pair = Collision_cached_pairs[i & mask];
+
+        if (pair.key == key) { return &pair; }
+        if (!pair.key) { return NULL; }
+    }
+}
+
+//
+// Returns the entry of a pair, adding it in the first stale or empty slot if
+// the pair is not cached. The entries of other pairs may move, so no pointer
+// to an entry survives the next call.
+//
+static collider_pair* collider_pair_get (std::uint64_t key, bool* created) {
+    // keep at least a quarter of the slots empty so that probes stay short
+    if ((Collision_cached_used + 1) * 4 > Collision_cached_pairs.size () * 3) {
+        collider_pair_rebuild ();
+    }
+
+    const size_t mask = Collision_cached_pairs.size () - 1;
+    collider_pair* slot = NULL;
+
+    for (size_t i = collider_pair_hash (key);; ++i) {
+        collider_pair& pair = Collision_cached_pairs[i & mask];
+
+        if (pair.key == key) {
+            *created = false;
+            return &pair;
+        }
+
+        if (!pair.key) {
+            if (!slot) {
+                slot = &pair;
+                ++Collision_cached_used;
+            }
+
+            break;
+        }
+
+        if (!slot && collider_pair_stale (pair)) { slot = &pair; }
+    }
+
+    slot->key = key;
+    *created = true;
+
+    return slot;
+}
+
+//
+// Narrow phase work. The sweep only collects the pairs that are due for a
+// check; the geometric tests then run on the worker pool and the results are
+// applied on this thread in pair key order, which keeps the outcome the same
+// for any number of threads.
+//
+struct collision_job {
+    std::uint64_t key;
+    obj_pair pair;
 };
 
-std::unordered_map< uint, collider_pair > Collision_cached_pairs;
+static std::vector< collision_job > Collision_jobs;
+static std::vector< ship_weapon_test > Collision_tests;
+
+// The ships that a collision response changed during the serial stage; the
+// tests of their later pairs were computed against the ship as it was before
+// and are done again
+static std::vector< bool > Collision_changed (MAX_OBJECTS);
+
+// The state of a ship that a collision response changes when it damages the
+// ship, destroys it, blows off its subsystems or pushes it away
+struct ship_collision_state {
+    float hull;
+    float subsystems;
+    bool dying;
+    bool dead;
+    vec3d pos;
+    matrix orient;
+
+    bool operator!= (const ship_collision_state& other) const {
+        return hull != other.hull || subsystems != other.subsystems ||
+               dying != other.dying || dead != other.dead ||
+               !vm_vec_same (&pos, &other.pos) ||
+               memcmp (&orient, &other.orient, sizeof orient) != 0;
+    }
+};
+
+static ship_collision_state obj_get_ship_collision_state (const object* objp) {
+    const ship& shipp = Ships[objp->instance];
+
+    ship_collision_state state;
+
+    state.hull = objp->hull_strength;
+    state.subsystems = 0.0f;
+
+    for (const auto& info : shipp.subsys_info) {
+        state.subsystems += info.aggregate_current_hits;
+    }
+
+    state.dying = shipp.flags[Ship::Ship_Flags::Dying];
+    state.dead = objp->flags[Object::Object_Flags::Should_be_dead];
+
+    state.pos = objp->pos;
+    state.orient = objp->orient;
+
+    return state;
+}
 
 extern checkobject CheckObjects[MAX_OBJECTS];
 
@@ -509,6 +709,7 @@ void obj_add_pair (object* A, object* B, int check_time, int add_to_end) {
     new_pair->a = A;
     new_pair->b = B;
     new_pair->check_collision = check_collision;
+    new_pair->test = NULL;
 
     if (check_time == -1) {
         new_pair->next_check_time =
@@ -1093,32 +1294,27 @@ int collide_remove_weapons () {
         }
     }
     else {
-        std::unordered_map< uint, collider_pair >::iterator it;
-        collider_pair* pair_obj;
-
-        for (it = Collision_cached_pairs.begin ();
-             it != Collision_cached_pairs.end (); ++it) {
-            pair_obj = &it->second;
+        for (auto& pair_obj : Collision_cached_pairs) {
+            if (!pair_obj.frame || !collider_pair_valid (pair_obj)) {
+                continue;
+            }
 
-            if (!pair_obj->initialized) { continue; }
+            object* A = &Objects[pair_obj.a];
+            object* B = &Objects[pair_obj.b];
 
-            if (pair_obj->a->type == OBJ_WEAPON &&
-                pair_obj->signature_a == pair_obj->a->signature) {
-                crw_check_weapon (
-                    pair_obj->a->instance, pair_obj->next_check_time);
+            if (A->type == OBJ_WEAPON) {
+                crw_check_weapon (A->instance, pair_obj.next_check_time);
 
-                if (crw_status[pair_obj->a->instance] == CRW_CAN_DELETE) {
-                    pair_obj->initialized = false;
+                if (crw_status[A->instance] == CRW_CAN_DELETE) {
+                    pair_obj.frame = 0;
                 }
             }
 
-            if (pair_obj->b->type == OBJ_WEAPON &&
-                pair_obj->signature_b == pair_obj->b->signature) {
-                crw_check_weapon (
-                    pair_obj->b->instance, pair_obj->next_check_time);
+            if (B->type == OBJ_WEAPON) {
+                crw_check_weapon (B->instance, pair_obj.next_check_time);
 
-                if (crw_status[pair_obj->b->instance] == CRW_CAN_DELETE) {
-                    pair_obj->initialized = false;
+                if (crw_status[B->instance] == CRW_CAN_DELETE) {
+                    pair_obj.frame = 0;
                 }
             }
         }
@@ -1202,7 +1398,18 @@ void obj_add_collider (int obj_index) {
 
     if (!(objp->flags[Object::Object_Flags::Not_in_coll])) { return; }
 
-    Collision_sort_list.push_back (obj_index);
+    // A collider that was removed and re-added before the next sort still
+    // has its endpoints in the axis lists, so only append genuinely new ones
+    if (!(Collider_state[obj_index] & COLLIDER_LISTED)) {
+        sap_endpoint endpoint = { 0.0f, 0.0f, obj_index };
+
+        for (auto& list : Collider_axis) { list.push_back (endpoint); }
+
+        ++Colliders_added;
+    }
+
+    Collider_state[obj_index] = COLLIDER_MEMBER | COLLIDER_LISTED;
+    Collider_pass[obj_index] = COLLIDER_PASS_NONE;
 
     objp->flags.remove (Object::Object_Flags::Not_in_coll);
 }
@@ -1212,210 +1419,329 @@ void obj_remove_collider (int obj_index) {
     CheckObjects[obj_index].flags.set (Object::Object_Flags::Not_in_coll);
 #endif
 
-    size_t i;
-
-    for (i = 0; i < Collision_sort_list.size (); ++i) {
-        if (Collision_sort_list[i] == obj_index) {
-            Collision_sort_list[i] = Collision_sort_list.back ();
-            Collision_sort_list.pop_back ();
-            break;
-        }
+    // The endpoints are dropped from the axis lists at the next sort, which
+    // keeps them in order and makes removal safe during the sweep itself
+    if (Collider_state[obj_index] & COLLIDER_MEMBER) {
+        Collider_state[obj_index] &= ~COLLIDER_MEMBER;
+        Collider_pass[obj_index] = COLLIDER_PASS_NONE;
+        ++Colliders_removed;
     }
 
     Objects[obj_index].flags.set (Object::Object_Flags::Not_in_coll);
 }
 
 void obj_reset_colliders () {
-    Collision_sort_list.clear ();
+    for (auto& list : Collider_axis) { list.clear (); }
+
+    memset (Collider_state, 0, sizeof Collider_state);
+
+    Colliders_added = Colliders_removed = 0;
+
     Collision_cached_pairs.clear ();
+    Collision_cached_used = 0;
+    Collision_cache_frame = 2;
 }
 
 void obj_collide_retime_cached_pairs (int checkdly) {
-    std::unordered_map< uint, collider_pair >::iterator it;
-
-    for (it = Collision_cached_pairs.begin ();
-         it != Collision_cached_pairs.end (); ++it) {
-        it->second.next_check_time = timestamp (checkdly);
+    for (auto& pair : Collision_cached_pairs) {
+        if (pair.key) { pair.next_check_time = timestamp (checkdly); }
     }
 }
 
-void obj_sort_and_collide () {
-    if (Cmdline_dis_collisions) return;
-
-    if (!(Game_detail_flags & DETAIL_FLAG_COLLISION)) return;
+//
+// Drops the endpoints of removed colliders and refreshes the cached bounds of
+// the remaining ones, once per frame and once per collider.
+//
+static void obj_update_collider_bounds () {
+    if (Colliders_removed) {
+        for (auto& list : Collider_axis) {
+            list.erase (
+                std::remove_if (
+                    list.begin (), list.end (),
+                    [](const sap_endpoint& endpoint) {
+                        return !(
+                            Collider_state[endpoint.objnum] &
+                            COLLIDER_MEMBER);
+                    }),
+                list.end ());
+        }
 
-    std::vector< int > sort_list_y;
-    std::vector< int > sort_list_z;
+        for (int i = 0; i < MAX_OBJECTS; ++i) {
+            if (!(Collider_state[i] & COLLIDER_MEMBER)) {
+                Collider_state[i] = 0;
+            }
+        }
 
-    sort_list_y.clear ();
-    {
-        TRACE_SCOPE (tracing::SortColliders);
-        obj_quicksort_colliders (
-            &Collision_sort_list, 0, (int)(Collision_sort_list.size () - 1),
-            0);
+        Colliders_removed = 0;
     }
-    obj_find_overlap_colliders (&sort_list_y, &Collision_sort_list, 0, false);
 
-    sort_list_z.clear ();
-    {
-        TRACE_SCOPE (tracing::SortColliders);
-        obj_quicksort_colliders (
-            &sort_list_y, 0, (int)(sort_list_y.size () - 1), 1);
+    for (const auto& endpoint : Collider_axis[0]) {
+        collider_bounds& bounds = Collider_bounds[endpoint.objnum];
+        obj_get_collider_bounds (endpoint.objnum, &bounds.min, &bounds.max);
+
+        Collider_pass[endpoint.objnum] = 0;
     }
-    obj_find_overlap_colliders (&sort_list_z, &sort_list_y, 1, false);
 
-    sort_list_y.clear ();
-    {
-        TRACE_SCOPE (tracing::SortColliders);
-        obj_quicksort_colliders (
-            &sort_list_z, 0, (int)(sort_list_z.size () - 1), 2);
+    for (int axis = 0; axis < 3; ++axis) {
+        for (auto& endpoint : Collider_axis[axis]) {
+            const collider_bounds& bounds = Collider_bounds[endpoint.objnum];
+
+            endpoint.min = bounds.min.a1d[axis];
+            endpoint.max = bounds.max.a1d[axis];
+        }
     }
-    obj_find_overlap_colliders (&sort_list_y, &sort_list_z, 2, true);
 }
 
-void obj_find_overlap_colliders (
-    std::vector< int >* overlap_list_out, std::vector< int >* list, int axis,
-    bool collide) {
-    TRACE_SCOPE (tracing::FindOverlapColliders);
+//
+// The axis lists are kept from one frame to the next and objects move little
+// in between, so an insertion sort restores the order in close to linear
+// time. A large batch of new colliders (e.g., at mission start) is sorted
+// from scratch instead.
+//
+static void obj_sort_collider_axis (std::vector< sap_endpoint >& list) {
+    const size_t n = list.size ();
+
+    if (Colliders_added > 64 && Colliders_added * 4 > n) {
+        std::sort (
+            list.begin (), list.end (),
+            [](const sap_endpoint& lhs, const sap_endpoint& rhs) {
+                return lhs.min < rhs.min;
+            });
+        return;
+    }
 
-    size_t i, j;
-    bool overlapped;
-    bool first_not_added = true;
-    std::vector< int > overlappers;
+    for (size_t i = 1; i < n; ++i) {
+        if (!(list[i].min < list[i - 1].min)) { continue; }
 
-    float min;
-    float overlap_max;
+        const sap_endpoint endpoint = list[i];
 
-    overlappers.clear ();
+        size_t j = i;
+        for (; j > 0 && endpoint.min < list[j - 1].min; --j) {
+            list[j] = list[j - 1];
+        }
 
-    for (i = 0; i < (*list).size (); ++i) {
-        overlapped = false;
+        list[j] = endpoint;
+    }
+}
 
-        min = obj_get_collider_endpoint ((*list)[i], axis, true);
+//
+// Runs the narrow phase over the pairs collected by the sweep. Only the
+// geometry of the ship:weapon pairs, by far the most numerous, is tested in
+// parallel; everything else, including the hit response, runs in order on
+// this thread.
+//
+static void obj_run_collision_jobs () {
+    if (Collision_jobs.empty ()) { return; }
+
+    std::sort (
+        Collision_jobs.begin (), Collision_jobs.end (),
+        [](const collision_job& lhs, const collision_job& rhs) {
+            return lhs.key < rhs.key;
+        });
+
+    if (Collision_tests.size () < Collision_jobs.size ()) {
+        Collision_tests.resize (Collision_jobs.size ());
+    }
 
-        for (j = 0; j < overlappers.size ();) {
-            overlap_max =
-                obj_get_collider_endpoint (overlappers[j], axis, false);
-            if (min <= overlap_max) {
-                overlapped = true;
+    {
+        TRACE_SCOPE (tracing::CollisionTests);
 
-                if (overlappers.size () == 1 && first_not_added) {
-                    first_not_added = false;
-                    overlap_list_out->push_back (overlappers[j]);
-                }
+        util::worker_pool ().parallel_for (
+            Collision_jobs.size (), 16, [](size_t first, size_t last) {
+                for (; first < last; ++first) {
+                    obj_pair& pair = Collision_jobs[first].pair;
 
-                if (collide) {
-                    obj_collide_pair (
-                        &Objects[(*list)[i]], &Objects[overlappers[j]]);
+                    if (pair.check_collision == collide_ship_weapon) {
+                        pair.test = &Collision_tests[first];
+                        collide_ship_weapon_test (&pair, pair.test);
+                    }
                 }
-            }
-            else {
-                overlappers[j] = overlappers.back ();
-                overlappers.pop_back ();
-                continue;
-            }
+            });
+    }
 
-            ++j;
-        }
+    TRACE_SCOPE (tracing::CollisionResponse);
 
-        if (overlappers.empty ()) { first_not_added = true; }
+    std::fill (Collision_changed.begin (), Collision_changed.end (), false);
 
-        if (overlapped) { overlap_list_out->push_back ((*list)[i]); }
+    for (auto& job : Collision_jobs) {
+        collider_pair* collision_info = collider_pair_find (job.key);
+        ASSERT (collision_info);
 
-        overlappers.push_back ((*list)[i]);
-    }
+        object* ship_objp = job.pair.a->type == OBJ_SHIP ? job.pair.a : NULL;
+        object* other_objp = job.pair.b->type == OBJ_SHIP ? job.pair.b : NULL;
 
-    overlapped = true;
-}
+        // The ship changed since its test was computed, test it again
+        if (job.pair.test && ship_objp &&
+            Collision_changed[OBJ_INDEX (ship_objp)]) {
+            job.pair.test = NULL;
+        }
 
-float obj_get_collider_endpoint (int obj_num, int axis, bool min) {
-    if (Objects[obj_num].type == OBJ_BEAM) {
-        beam* b = &Beams[Objects[obj_num].instance];
+        // A test still in use was computed against the ship where it is now
+        ASSERTX (
+            !job.pair.test || !job.pair.test->done ||
+                (vm_vec_same (&job.pair.test->ship_pos, &ship_objp->pos) &&
+                 vm_matrix_same (
+                     &job.pair.test->ship_orient, &ship_objp->orient)),
+            "Stale ship:weapon test used for %s",
+            Ships[ship_objp->instance].ship_name);
 
-        // use the last start and last shot as endpoints
-        float min_end, max_end;
-        if (b->last_start.a1d[axis] > b->last_shot.a1d[axis]) {
-            min_end = b->last_shot.a1d[axis];
-            max_end = b->last_start.a1d[axis];
-        }
-        else {
-            min_end = b->last_start.a1d[axis];
-            max_end = b->last_shot.a1d[axis];
+        ship_collision_state ship_state, other_state;
+
+        if (ship_objp) {
+            ship_state = obj_get_ship_collision_state (ship_objp);
         }
 
-        if (min) { return min_end; }
-        else {
-            return max_end;
+        if (other_objp) {
+            other_state = obj_get_ship_collision_state (other_objp);
         }
-    }
-    else if (Objects[obj_num].type == OBJ_WEAPON) {
-        float min_end, max_end;
 
-        if (Objects[obj_num].pos.a1d[axis] >
-            Objects[obj_num].last_pos.a1d[axis]) {
-            min_end = Objects[obj_num].last_pos.a1d[axis];
-            max_end = Objects[obj_num].pos.a1d[axis];
+        const int result = job.pair.check_collision (&job.pair);
+
+        if (ship_objp &&
+            obj_get_ship_collision_state (ship_objp) != ship_state) {
+            Collision_changed[OBJ_INDEX (ship_objp)] = true;
         }
-        else {
-            min_end = Objects[obj_num].pos.a1d[axis];
-            max_end = Objects[obj_num].last_pos.a1d[axis];
+
+        if (other_objp &&
+            obj_get_ship_collision_state (other_objp) != other_state) {
+            Collision_changed[OBJ_INDEX (other_objp)] = true;
         }
 
-        if (min) { return min_end - Objects[obj_num].radius; }
+        if (result) {
+            // don't have to check ever again
+            collision_info->next_check_time = -1;
+        }
         else {
-            return max_end + Objects[obj_num].radius;
+            collision_info->next_check_time = job.pair.next_check_time;
         }
     }
-    else {
-        vec3d* pos = &Objects[obj_num].pos;
 
-        if (min) { return pos->a1d[axis] - Objects[obj_num].radius; }
-        else {
-            return pos->a1d[axis] + Objects[obj_num].radius;
-        }
+    Collision_jobs.clear ();
+}
+
+void obj_sort_and_collide () {
+    if (Cmdline_dis_collisions) return;
+
+    if (!(Game_detail_flags & DETAIL_FLAG_COLLISION)) return;
+
+    {
+        TRACE_SCOPE (tracing::SortColliders);
+
+        obj_update_collider_bounds ();
+
+        for (auto& list : Collider_axis) { obj_sort_collider_axis (list); }
+
+        Colliders_added = 0;
     }
+
+    Collision_jobs.clear ();
+
+    // pairs seen in this frame stay in the cache for the next one
+    ++Collision_cache_frame;
+
+    // Each pass only considers the colliders that overlapped some other
+    // collider on all previous axes; the last one collects the pairs for the
+    // narrow phase
+    obj_find_overlap_colliders (0, false);
+    obj_find_overlap_colliders (1, false);
+    obj_find_overlap_colliders (2, true);
+
+    obj_run_collision_jobs ();
 }
 
-void obj_quicksort_colliders (
-    std::vector< int >* list, int left, int right, int axis) {
+void obj_find_overlap_colliders (int axis, bool collide) {
+    TRACE_SCOPE (tracing::FindOverlapColliders);
+
     ASSERT (axis >= 0);
     ASSERT (axis <= 2);
 
-    if (right > left) {
-        int pivot_index = left + (right - left) / 2;
+    static std::vector< sap_endpoint > overlappers;
+    overlappers.clear ();
 
-        float pivot_value =
-            obj_get_collider_endpoint ((*list)[pivot_index], axis, true);
+    const ubyte pass = ubyte (axis);
 
-        // swap!
-        int temp = (*list)[pivot_index];
-        (*list)[pivot_index] = (*list)[right];
-        (*list)[right] = temp;
+    // colliders added during the sweep are appended to the list and take
+    // part in the sort starting with the next frame
+    const std::vector< sap_endpoint >& list = Collider_axis[axis];
 
-        int store_index = left;
+    for (size_t i = 0, n = list.size (); i < n; ++i) {
+        const sap_endpoint endpoint = list[i];
 
-        int i;
-        for (i = left; i < right; ++i) {
-            if (obj_get_collider_endpoint ((*list)[i], axis, true) <=
-                pivot_value) {
-                temp = (*list)[i];
-                (*list)[i] = (*list)[store_index];
-                (*list)[store_index] = temp;
-                store_index++;
+        if (Collider_pass[endpoint.objnum] != pass) { continue; }
+
+        bool overlapped = false;
+
+        for (size_t j = 0; j < overlappers.size ();) {
+            const sap_endpoint& other = overlappers[j];
+
+            if (endpoint.min <= other.max &&
+                Collider_pass[other.objnum] != COLLIDER_PASS_NONE) {
+                overlapped = true;
+
+                if (Collider_pass[other.objnum] == pass) {
+                    Collider_pass[other.objnum] = pass + 1;
+                }
+
+                if (collide) {
+                    obj_collide_pair (
+                        &Objects[endpoint.objnum], &Objects[other.objnum]);
+                }
             }
+            else if (endpoint.min > other.max) {
+                overlappers[j] = overlappers.back ();
+                overlappers.pop_back ();
+                continue;
+            }
+
+            ++j;
         }
 
-        temp = (*list)[right];
-        (*list)[right] = (*list)[store_index];
-        (*list)[store_index] = temp;
+        if (overlapped && Collider_pass[endpoint.objnum] == pass) {
+            Collider_pass[endpoint.objnum] = pass + 1;
+        }
+
+        overlappers.push_back (endpoint);
+    }
+}
+
+void obj_get_collider_bounds (int obj_num, vec3d* min, vec3d* max) {
+    const object_hot& hot = Object_hot;
+
+    const vec3d& pos = hot.pos[obj_num];
+    const float radius = hot.radius[obj_num];
 
-        obj_quicksort_colliders (list, left, store_index - 1, axis);
-        obj_quicksort_colliders (list, store_index + 1, right, axis);
+    if (hot.type[obj_num] == OBJ_BEAM) {
+        const beam* b = &Beams[Objects[obj_num].instance];
+
+        // use the last start and last shot as endpoints
+        for (int axis = 0; axis < 3; ++axis) {
+            min->a1d[axis] = (std::min) (
+                b->last_start.a1d[axis], b->last_shot.a1d[axis]);
+            max->a1d[axis] = (std::max) (
+                b->last_start.a1d[axis], b->last_shot.a1d[axis]);
+        }
+    }
+    else if (hot.type[obj_num] == OBJ_WEAPON) {
+        const vec3d& last_pos = hot.last_pos[obj_num];
+
+        // sweep the weapon over the distance travelled this frame
+        for (int axis = 0; axis < 3; ++axis) {
+            min->a1d[axis] =
+                (std::min) (pos.a1d[axis], last_pos.a1d[axis]) - radius;
+            max->a1d[axis] =
+                (std::max) (pos.a1d[axis], last_pos.a1d[axis]) + radius;
+        }
+    }
+    else {
+        for (int axis = 0; axis < 3; ++axis) {
+            min->a1d[axis] = pos.a1d[axis] - radius;
+            max->a1d[axis] = pos.a1d[axis] + radius;
+        }
     }
 }
 
 void obj_collide_pair (object* A, object* B) {
-    TRACE_SCOPE (tracing::CollidePair);
+    TRACE_DETAIL_SCOPE (tracing::CollidePair);
 
     uint ctype;
     int (*check_collision) (obj_pair * pair);
@@ -1569,36 +1895,22 @@ void obj_collide_pair (object* A, object* B) {
         B = tmp;
     }
 
-    collider_pair* collision_info = NULL;
-    bool valid = false;
-    uint key = (OBJ_INDEX (A) << 12) + OBJ_INDEX (B);
+    std::uint64_t key = collider_pair_key (A, B);
 
-    collision_info = &Collision_cached_pairs[key];
+    bool created;
+    collider_pair* collision_info = collider_pair_get (key, &created);
 
-    if (collision_info->initialized) {
-        // make sure we're referring to the correct objects in case the
-        // original pair was deleted
-        if (collision_info->signature_a == collision_info->a->signature &&
-            collision_info->signature_b == collision_info->b->signature) {
-            valid = true;
-        }
-        else {
-            collision_info->a = A;
-            collision_info->b = B;
-            collision_info->signature_a = A->signature;
-            collision_info->signature_b = B->signature;
-            collision_info->next_check_time = timestamp (0);
-        }
-    }
-    else {
-        collision_info->a = A;
-        collision_info->b = B;
-        collision_info->signature_a = A->signature;
-        collision_info->signature_b = B->signature;
-        collision_info->initialized = true;
+    if (created) {
+        collision_info->a = short (OBJ_INDEX (A));
+        collision_info->b = short (OBJ_INDEX (B));
         collision_info->next_check_time = timestamp (0);
     }
 
+    collision_info->frame = Collision_cache_frame;
+
+    // entries are keyed by signature, so an existing one is always valid
+    bool valid = !created;
+
     if (valid && A->type != OBJ_BEAM) {
         // if this signature is valid, make the necessary checks to see if we
         // need to collide check
@@ -1697,18 +2009,15 @@ void obj_collide_pair (object* A, object* B) {
         }
     }
 
-    obj_pair new_pair;
+    collision_job job;
 
-    new_pair.a = A;
-    new_pair.b = B;
-    new_pair.check_collision = check_collision;
-    new_pair.next_check_time = collision_info->next_check_time;
+    job.key = key;
+    job.pair.a = A;
+    job.pair.b = B;
+    job.pair.check_collision = check_collision;
+    job.pair.next_check_time = collision_info->next_check_time;
+    job.pair.next = NULL;
+    job.pair.test = NULL;
 
-    if (check_collision (&new_pair)) {
-        // don't have to check ever again
-        collision_info->next_check_time = -1;
-    }
-    else {
-        collision_info->next_check_time = new_pair.next_check_time;
-    }
+    Collision_jobs.push_back (job);
 }
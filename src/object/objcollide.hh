@@ -4,10 +4,10 @@
 #define FREESPACE2_OBJECT_OBJCOLLIDE_HH
 
 #include "defs.hh"
+#include "model/model.hh"
 
 class object;
 struct CFILE;
-struct mc_info;
 
 // used for ship:ship and ship:debris
 struct collision_info_struct  {
@@ -41,6 +41,19 @@ struct collision_info_struct  {
 // collision- type specific collision modules.
 //===============================================================================
 
+// Result of the geometric part of a ship:weapon collision check, computed
+// ahead of time by the narrow phase workers
+struct ship_weapon_test {
+    bool done; // set if the test ran and the fields below are valid
+    vec3d ship_pos;      // where the ship was when tested
+    matrix ship_orient;
+    vec3d weapon_end_pos;
+    mc_info mc_shield;
+    mc_info mc_hull;
+    int shield_collision;
+    int hull_collision;
+};
+
 // Keeps track of pairs of objects for collision detection
 struct obj_pair  {
     object* a;
@@ -49,6 +62,7 @@ struct obj_pair  {
     int next_check_time; // a timestamp that when elapsed means to check for a
                          // collision
     struct obj_pair* next;
+    ship_weapon_test* test; // precomputed ship:weapon geometry, or NULL
 };
 
 #define COLLISION_OF(a, b) (((a) << 8) | (b))
@@ -77,12 +91,8 @@ void obj_reset_colliders ();
 
 void obj_check_all_collisions ();
 void obj_sort_and_collide ();
-void obj_quicksort_colliders (
-    std::vector< int >* list, int left, int right, int axis);
-void obj_find_overlap_colliders (
-    std::vector< int >* overlap_list_out, std::vector< int >* list, int axis,
-    bool collide);
-float obj_get_collider_endpoint (int obj_num, int axis, bool min);
+void obj_find_overlap_colliders (int axis, bool collide);
+void obj_get_collider_bounds (int obj_num, vec3d* min, vec3d* max);
 void obj_collide_pair (object* A, object* B);
 
 // retimes all collision pairs to be checked (in 25ms by default)
@@ -116,6 +126,11 @@ int collide_weapon_weapon (obj_pair* pair);
 // CODE is locatated in CollideShipWeapon.cpp
 int collide_ship_weapon (obj_pair* pair);
 
+// Runs the geometric part of collide_ship_weapon without touching any game
+// state, so that it can be called from worker threads.  Leaves test->done
+// unset when the pair takes a path that cannot be precomputed.
+void collide_ship_weapon_test (obj_pair* pair, ship_weapon_test* test);
+
 // Checks debris-weapon collisions.  pair->a is debris and pair->b is weapon.
 // Returns 1 if all future collisions between these can be ignored
 // CODE is locatated in CollideDebrisWeapon.cpp
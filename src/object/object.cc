@@ -21,6 +21,7 @@
 #include "object/objcollide.hh"
 #include "object/object.hh"
 #include "object/objectdock.hh"
+#include "object/objectgrid.hh"
 #include "object/objectshield.hh"
 #include "object/objectsnd.hh"
 #include "observer/observer.hh"
@@ -32,6 +33,7 @@
 #include "ship/ship.hh"
 #include "tracing/Monitor.hh"
 #include "tracing/tracing.hh"
+#include "util/ThreadPool.hh"
 #include "util/list.hh"
 #include "weapon/beam.hh"
 #include "weapon/shockwave.hh"
@@ -50,9 +52,29 @@ object* Player_obj = NULL;
 object* Viewer_obj = NULL;
 
 extern int Cmdline_old_collision_sys;
+extern int Cmdline_parallel_physics;
 
 // Data for objects
 object Objects[MAX_OBJECTS];
+object_hot Object_hot;
+
+// The physics of an object as seen by physics_sim
+struct obj_physics_state {
+    vec3d pos;
+    matrix orient;
+    physics_info pi;
+};
+
+// A physics_sim result computed ahead of the move loop, together with the
+// state it was computed from
+struct obj_physics_job {
+    int objnum;
+    obj_physics_state in;
+    obj_physics_state out;
+};
+
+static std::vector< obj_physics_job > Physics_jobs;
+static int Physics_job_of[MAX_OBJECTS]; // index in Physics_jobs, or -1
 
 #ifdef OBJECT_CHECK
 checkobject CheckObjects[MAX_OBJECTS];
@@ -331,6 +353,81 @@ float get_shield_pct (object* objp) {
     return shield_get_strength (objp) / total_strength;
 }
 
+/**
+ * Moves an object from the hot type list of its old type to the one of its new
+ * type; OBJ_NONE objects are in no list
+ */
+static void obj_hot_set_type (int objnum, int type) {
+    object_hot& hot = Object_hot;
+
+    int old_type = hot.type[objnum];
+
+    if (old_type != OBJ_NONE) {
+        short* list = hot.by_type[old_type];
+        int slot = hot.type_slot[objnum];
+        int last = list[--hot.n_by_type[old_type]];
+
+        list[slot] = short (last);
+        hot.type_slot[last] = short (slot);
+    }
+
+    if (type != OBJ_NONE) {
+        int slot = hot.n_by_type[type]++;
+
+        hot.by_type[type][slot] = short (objnum);
+        hot.type_slot[objnum] = short (slot);
+    }
+
+    hot.type[objnum] = char (type);
+}
+
+void obj_hot_update (int objnum) {
+    object_hot& hot = Object_hot;
+    const object* objp = &Objects[objnum];
+
+    hot.pos[objnum] = objp->pos;
+    hot.last_pos[objnum] = objp->last_pos;
+    hot.radius[objnum] = objp->radius;
+
+    ubyte flags = 0;
+
+    if (objp->flags[Object::Object_Flags::Collides]) {
+        flags |= OBJ_HOT_COLLIDES;
+    }
+
+    if (objp->flags[Object::Object_Flags::Should_be_dead]) {
+        flags |= OBJ_HOT_SHOULD_BE_DEAD;
+    }
+
+    if (objp->flags[Object::Object_Flags::Player_ship]) {
+        flags |= OBJ_HOT_PLAYER_SHIP;
+    }
+
+    if (objp->flags[Object::Object_Flags::Immobile]) {
+        flags |= OBJ_HOT_IMMOBILE;
+    }
+
+    hot.flags[objnum] = flags;
+}
+
+/**
+ * Refreshes the hot copies of all the objects, including the ones created this
+ * frame
+ */
+static void obj_hot_update_all () {
+    object* objp;
+
+    for (objp = GET_FIRST (&obj_used_list);
+         objp != END_OF_LIST (&obj_used_list); objp = GET_NEXT (objp)) {
+        obj_hot_update (OBJ_INDEX (objp));
+    }
+
+    for (objp = GET_FIRST (&obj_create_list);
+         objp != END_OF_LIST (&obj_create_list); objp = GET_NEXT (objp)) {
+        obj_hot_update (OBJ_INDEX (objp));
+    }
+}
+
 /**
  * Sets up the free list & init player & whatever else
  */
@@ -342,6 +439,12 @@ void obj_init () {
     for (i = 0; i < MAX_OBJECTS; ++i) Objects[i].clear ();
     Viewer_obj = NULL;
 
+    memset (&Object_hot, 0, sizeof Object_hot);
+    obj_grid_reset ();
+
+    Physics_jobs.clear ();
+    for (i = 0; i < MAX_OBJECTS; ++i) Physics_job_of[i] = -1;
+
     list_init (&obj_free_list);
     list_init (&obj_used_list);
     list_init (&obj_create_list);
@@ -526,6 +629,9 @@ int obj_create (
         DEFAULT_SHIELD_SECTIONS; // Might be changed by the ship creation code
     obj->shield_quadrant.resize (obj->n_quadrants);
 
+    obj_hot_set_type (objnum, type);
+    obj_hot_update (objnum);
+
     return objnum;
 }
 
@@ -569,6 +675,8 @@ void obj_delete (int objnum) {
             objp->type = OBJ_GHOST;
             objp->flags.remove (Object::Object_Flags::Should_be_dead);
 
+            obj_hot_set_type (objnum, OBJ_GHOST);
+
             // we have to traverse the ship_obj list and remove this guy from
             // it as well
             ship_obj* moveup = GET_FIRST (&Ship_obj_list);
@@ -626,6 +734,8 @@ void obj_delete (int objnum) {
     objp->type = OBJ_NONE; // unused!
     objp->signature = 0;
 
+    obj_hot_set_type (objnum, OBJ_NONE);
+
     obj_free (objnum);
 }
 
@@ -776,8 +886,104 @@ void obj_player_fire_stuff (object* objp, control_info ci) {
     if (ci.afterburner_stop) { afterburners_stop (objp, 1); }
 }
 
+static void obj_physics_get (obj_physics_state* state, const object* objp) {
+    // byte copies, so that the comparison in obj_physics_sim is exact
+    memcpy (&state->pos, &objp->pos, sizeof state->pos);
+    memcpy (&state->orient, &objp->orient, sizeof state->orient);
+    memcpy (&state->pi, &objp->phys_info, sizeof state->pi);
+}
+
+static bool
+obj_physics_same (const obj_physics_state* state, const object* objp) {
+    return !memcmp (&state->pos, &objp->pos, sizeof state->pos) &&
+           !memcmp (&state->orient, &objp->orient, sizeof state->orient) &&
+           !memcmp (&state->pi, &objp->phys_info, sizeof state->pi);
+}
+
+/**
+ * Runs physics_sim for the undocked, non-player objects on the worker pool,
+ * from their state before the move loop. physics_sim only reads the object it
+ * is given and the frame time (except for the shockwave shake, which uses the
+ * global random numbers), so obj_physics_sim can take these results for
+ * any object whose state is still the same when the serial loop reaches it,
+ * and the outcome does not differ from the serial one by a single bit.
+ */
+static void obj_physics_predict (float frametime) {
+    for (const obj_physics_job& job : Physics_jobs) {
+        Physics_job_of[job.objnum] = -1;
+    }
+
+    Physics_jobs.clear ();
+
+    if (!Cmdline_parallel_physics || physics_paused) { return; }
+    if (util::worker_pool ().size () < 2) { return; }
+
+    TRACE_SCOPE (tracing::ParallelPhysics);
+
+    object* objp;
+
+    for (objp = GET_FIRST (&obj_used_list);
+         objp != END_OF_LIST (&obj_used_list); objp = GET_NEXT (objp)) {
+        if (!objp->flags[Object::Object_Flags::Physics]) { continue; }
+        if (objp->flags[Object::Object_Flags::Should_be_dead]) { continue; }
+
+        if (objp->type == OBJ_OBSERVER || objp == Player_obj) { continue; }
+        if (object_is_docked (objp)) { continue; }
+
+        // the shockwave shake draws from the global random numbers, which
+        // have to be drawn in the order of the loop
+        if (objp->phys_info.flags & PF_IN_SHOCKWAVE) { continue; }
+
+        if (objp->flags[Object::Object_Flags::Immobile] &&
+            objp->hull_strength > 0.0f) {
+            continue;
+        }
+
+        Physics_job_of[OBJ_INDEX (objp)] = int (Physics_jobs.size ());
+
+        Physics_jobs.emplace_back ();
+        Physics_jobs.back ().objnum = OBJ_INDEX (objp);
+
+        obj_physics_get (&Physics_jobs.back ().in, objp);
+    }
+
+    util::worker_pool ().parallel_for (
+        Physics_jobs.size (), 32, [frametime](size_t first, size_t last) {
+            for (; first < last; ++first) {
+                obj_physics_job& job = Physics_jobs[first];
+
+                job.out = job.in;
+                physics_sim (
+                    &job.out.pos, &job.out.orient, &job.out.pi, frametime);
+            }
+        });
+}
+
+/**
+ * physics_sim for an object in the move loop, taking the result of
+ * obj_physics_predict when the object has not changed since
+ */
+static void obj_physics_sim (object* objp, float frametime) {
+    const int objnum = OBJ_INDEX (objp);
+    const int index = Physics_job_of[objnum];
+
+    if (index >= 0) {
+        const obj_physics_job& job = Physics_jobs[index];
+        Physics_job_of[objnum] = -1;
+
+        if (obj_physics_same (&job.in, objp)) {
+            memcpy (&objp->pos, &job.out.pos, sizeof objp->pos);
+            memcpy (&objp->orient, &job.out.orient, sizeof objp->orient);
+            memcpy (&objp->phys_info, &job.out.pi, sizeof objp->phys_info);
+            return;
+        }
+    }
+
+    physics_sim (&objp->pos, &objp->orient, &objp->phys_info, frametime);
+}
+
 void obj_move_call_physics (object* objp, float frametime) {
-    TRACE_SCOPE (tracing::Physics);
+    TRACE_DETAIL_SCOPE (tracing::Physics);
 
     int has_fired = -1; // stop fireing stuff-Bobboau
 
@@ -922,9 +1128,7 @@ void obj_move_call_physics (object* objp, float frametime) {
                 }
             }
 
-            physics_sim (
-                &objp->pos, &objp->orient, &objp->phys_info,
-                frametime); // simulate the physics
+            obj_physics_sim (objp, frametime); // simulate the physics
 
             // if the object is the player object, do things that need to be
             // done after the ship is moved (like firing weapons, etc).  This
@@ -1108,7 +1312,7 @@ void obj_set_flags (
 }
 
 void obj_move_all_pre (object* objp, float frametime) {
-    TRACE_SCOPE (tracing::PreMove);
+    TRACE_DETAIL_SCOPE (tracing::PreMove);
 
     switch (objp->type) {
     case OBJ_WEAPON:
@@ -1166,7 +1370,7 @@ extern fireball Fireballs[];
 void obj_move_all_post (object* objp, float frametime) {
     switch (objp->type) {
     case OBJ_WEAPON: {
-        TRACE_SCOPE (tracing::WeaponPostMove);
+        TRACE_DETAIL_SCOPE (tracing::WeaponPostMove);
 
         if (!physics_paused) weapon_process_post (objp, frametime);
 
@@ -1219,7 +1423,7 @@ void obj_move_all_post (object* objp, float frametime) {
     }
 
     case OBJ_SHIP: {
-        TRACE_SCOPE (tracing::ShipPostMove);
+        TRACE_DETAIL_SCOPE (tracing::ShipPostMove);
 
         if (!physics_paused || (objp == Player_obj)) {
             ship_process_post (objp, frametime);
@@ -1274,7 +1478,7 @@ void obj_move_all_post (object* objp, float frametime) {
     }
 
     case OBJ_FIREBALL: {
-        TRACE_SCOPE (tracing::FireballPostMove);
+        TRACE_DETAIL_SCOPE (tracing::FireballPostMove);
 
         if (!physics_paused) fireball_process_post (objp, frametime);
 
@@ -1318,7 +1522,7 @@ void obj_move_all_post (object* objp, float frametime) {
         break;
 
     case OBJ_DEBRIS: {
-        TRACE_SCOPE (tracing::DebrisPostMove);
+        TRACE_DETAIL_SCOPE (tracing::DebrisPostMove);
 
         if (!physics_paused) debris_process_post (objp, frametime);
 
@@ -1358,7 +1562,7 @@ void obj_move_all_post (object* objp, float frametime) {
     }
 
     case OBJ_ASTEROID: {
-        TRACE_SCOPE (tracing::AsteroidPostMove);
+        TRACE_DETAIL_SCOPE (tracing::AsteroidPostMove);
 
         if (!physics_paused) asteroid_process_post (objp);
 
@@ -1416,6 +1620,13 @@ void obj_move_all (float frametime) {
 
     obj_merge_created_list ();
 
+    // index the objects for the range queries made while they move
+    obj_grid_build (frametime);
+
+    // integrate the physics of the objects that move on their own ahead of
+    // the serial loop below
+    obj_physics_predict (frametime);
+
     // Clear the table that tells which groups of weapons have cast light so
     // far.
     obj_clear_weapon_group_id_list ();
@@ -1538,6 +1749,9 @@ void obj_move_all (float frametime) {
         objp = GET_NEXT (objp);
     }
 
+    // everything has moved, docked objects included
+    obj_hot_update_all ();
+
     if (!cmeasure_list.empty ())
         find_homing_object_cmeasures (
             cmeasure_list); // If any cmeasures are active, maybe steer away
@@ -229,6 +229,45 @@ extern int render_order[MAX_OBJECTS];
 extern object* Viewer_obj; // Which object is the viewer. Can be NULL.
 extern object* Player_obj; // Which object is the player. Has to be valid.
 
+// Copies of the object fields that broad scans need, one array per field and
+// indexed by objnum, so that a scan touches a few cache lines instead of one
+// whole object per step. obj_create and obj_delete keep the type lists up to
+// date; the positions and flags are refreshed by obj_move_all once everything
+// has moved, or by obj_hot_update for objects moved outside of it.
+#define OBJ_HOT_COLLIDES (1 << 0)
+#define OBJ_HOT_SHOULD_BE_DEAD (1 << 1)
+#define OBJ_HOT_PLAYER_SHIP (1 << 2)
+#define OBJ_HOT_IMMOBILE (1 << 3)
+
+struct object_hot {
+    vec3d pos[MAX_OBJECTS];
+    vec3d last_pos[MAX_OBJECTS];
+    float radius[MAX_OBJECTS];
+    char type[MAX_OBJECTS];
+    ubyte flags[MAX_OBJECTS]; // OBJ_HOT_* bits
+
+    // the live objects of each type, in no particular order
+    short by_type[MAX_OBJECT_TYPES][MAX_OBJECTS];
+    int n_by_type[MAX_OBJECT_TYPES];
+    short type_slot[MAX_OBJECTS]; // where an object is in its type list
+};
+
+extern object_hot Object_hot;
+
+// The objnums of the live objects of one type, for range based for loops
+struct object_hot_range {
+    const short* first;
+    const short* last;
+
+    const short* begin () const { return first; }
+    const short* end () const { return last; }
+};
+
+inline object_hot_range obj_hot_of_type (int type) {
+    const short* first = Object_hot.by_type[type];
+    return { first, first + Object_hot.n_by_type[type] };
+}
+
 // Use this instead of "objp - Objects" to get an object number
 // given it's pointer.  This way, we can replace it with a macro
 // to check that the pointer is valid for debugging.
@@ -270,6 +309,9 @@ void obj_move_all (float frametime); // moves all objects
 // editor code
 void obj_delete (int objnum);
 
+// refreshes the hot copies of the position, radius and flags of an object
+void obj_hot_update (int objnum);
+
 void obj_delete_all ();
 
 // should only be used by the editor!
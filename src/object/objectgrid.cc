@@ -0,0 +1,395 @@
+// -*- mode: c++; -*-
+
+#include "defs.hh"
+
+#include "assert/assert.hh"
+#include "math/vecmat.hh"
+#include "object/object.hh"
+#include "object/objectgrid.hh"
+#include "tracing/tracing.hh"
+#include "util/list.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Objects are hashed by the cell of their center. Objects larger than half a
+// cell are kept aside and tested by every query.
+#define OBJ_GRID_CELL_SIZE 500.0f
+#define OBJ_GRID_LARGE_RADIUS (OBJ_GRID_CELL_SIZE * 0.5f)
+
+// cells are packed into 21 bits per axis, which covers +/- 500000 km
+#define OBJ_GRID_CELL_BITS 21
+#define OBJ_GRID_CELL_BIAS (1 << (OBJ_GRID_CELL_BITS - 1))
+#define OBJ_GRID_CELL_MASK ((1 << OBJ_GRID_CELL_BITS) - 1)
+
+// slack added to the motion margin, for objects that jump a little
+#define OBJ_GRID_SLACK 10.0f
+
+// the bounding box of a ship model can stick out of its bounding sphere up to
+// the corners of the enclosing cube
+#define OBJ_GRID_SHIP_BOUND 1.7321f
+
+struct obj_grid_cell {
+    std::uint64_t key; // 0 marks an empty slot
+    int first;         // first item of the cell
+    int count;
+};
+
+// the state of each object at the last build, indexed by objnum
+static vec3d Grid_pos[MAX_OBJECTS];
+static float Grid_radius[MAX_OBJECTS];
+static int Grid_signature[MAX_OBJECTS];
+static int Grid_rank[MAX_OBJECTS]; // position in obj_used_list
+static char Grid_type[MAX_OBJECTS];
+
+static std::vector< std::uint64_t > Grid_keys;
+static std::vector< short > Grid_items; // objnums, grouped by cell
+static std::vector< short > Grid_large;
+static std::vector< obj_grid_cell > Grid_cells; // power of two open addressing
+static std::vector< int > Grid_used_cells;      // slots of the cells in use
+
+static float Grid_margin = 0.0f;
+static bool Grid_valid = false;
+
+static inline int obj_grid_coord (float x) {
+    int i = int (std::floor (x * (1.0f / OBJ_GRID_CELL_SIZE)));
+    return (std::max) (
+        -OBJ_GRID_CELL_BIAS, (std::min) (OBJ_GRID_CELL_BIAS - 1, i));
+}
+
+static inline std::uint64_t obj_grid_key (int x, int y, int z) {
+    // never 0, that is the empty slot
+    return (std::uint64_t (1) << 63) |
+           (std::uint64_t ((x + OBJ_GRID_CELL_BIAS) & OBJ_GRID_CELL_MASK)
+            << (2 * OBJ_GRID_CELL_BITS)) |
+           (std::uint64_t ((y + OBJ_GRID_CELL_BIAS) & OBJ_GRID_CELL_MASK)
+            << OBJ_GRID_CELL_BITS) |
+           std::uint64_t ((z + OBJ_GRID_CELL_BIAS) & OBJ_GRID_CELL_MASK);
+}
+
+static inline size_t obj_grid_hash (std::uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return size_t (key);
+}
+
+static const obj_grid_cell* obj_grid_find (std::uint64_t key) {
+    const size_t mask = Grid_cells.size () - 1;
+
+    for (size_t i = obj_grid_hash (key);; ++i) {
+        const obj_grid_cell& cell = Grid_cells[i & mask];
+
+        if (cell.key == key) { return &cell; }
+        if (cell.key == 0) { return NULL; }
+    }
+}
+
+/**
+ * The radius a query has to reach for an object, which covers the model
+ * bounding box for ships
+ */
+static inline float obj_grid_bound (const object* objp) {
+    return objp->type == OBJ_SHIP ? objp->radius * OBJ_GRID_SHIP_BOUND
+                                  : objp->radius;
+}
+
+/**
+ * An upper bound on the speed of an object until the next build
+ */
+static float obj_grid_speed (const object* objp) {
+    const physics_info& pi = objp->phys_info;
+
+    float speed = (std::max) (
+        vm_vec_mag_quick (&pi.vel), vm_vec_mag_quick (&pi.max_vel));
+
+    speed = (std::max) (speed, vm_vec_mag_quick (&pi.afterburner_max_vel));
+    speed = (std::max) (speed, vm_vec_mag_quick (&pi.booster_max_vel));
+
+    return speed;
+}
+
+void obj_grid_reset () {
+    Grid_keys.clear ();
+    Grid_items.clear ();
+    Grid_large.clear ();
+    Grid_cells.clear ();
+    Grid_used_cells.clear ();
+
+    Grid_margin = 0.0f;
+    Grid_valid = false;
+}
+
+void obj_grid_build (float frametime) {
+    TRACE_SCOPE (tracing::ObjectGrid);
+
+    Grid_keys.clear ();
+    Grid_items.clear ();
+    Grid_large.clear ();
+    Grid_used_cells.clear ();
+
+    float max_speed = 0.0f;
+    int rank = 0;
+
+    object* objp;
+
+    for (objp = GET_FIRST (&obj_used_list);
+         objp != END_OF_LIST (&obj_used_list); objp = GET_NEXT (objp)) {
+        const int objnum = OBJ_INDEX (objp);
+
+        Grid_pos[objnum] = objp->pos;
+        Grid_radius[objnum] = obj_grid_bound (objp);
+        Grid_signature[objnum] = objp->signature;
+        Grid_rank[objnum] = rank++;
+        Grid_type[objnum] = char (objp->type);
+
+        max_speed = (std::max) (max_speed, obj_grid_speed (objp));
+
+        if (Grid_radius[objnum] > OBJ_GRID_LARGE_RADIUS) {
+            Grid_large.push_back (short (objnum));
+            continue;
+        }
+
+        Grid_keys.push_back (obj_grid_key (
+            obj_grid_coord (objp->pos.xyz.x), obj_grid_coord (objp->pos.xyz.y),
+            obj_grid_coord (objp->pos.xyz.z)));
+
+        Grid_items.push_back (short (objnum));
+    }
+
+    // the objects move at most this far from where they were seen here
+    // before the next build
+    Grid_margin = max_speed * frametime * 1.25f + OBJ_GRID_SLACK;
+
+    // group the items by cell; the keys and items are sorted together
+    const size_t n = Grid_items.size ();
+
+    {
+        std::vector< std::pair< std::uint64_t, short > > sorted (n);
+
+        for (size_t i = 0; i < n; ++i) {
+            sorted[i] = std::make_pair (Grid_keys[i], Grid_items[i]);
+        }
+
+        std::sort (sorted.begin (), sorted.end ());
+
+        for (size_t i = 0; i < n; ++i) {
+            Grid_keys[i] = sorted[i].first;
+            Grid_items[i] = sorted[i].second;
+        }
+    }
+
+    size_t size = 64;
+    while (size < n * 2) { size <<= 1; }
+
+    Grid_cells.assign (size, obj_grid_cell{ 0, 0, 0 });
+
+    for (size_t i = 0; i < n;) {
+        size_t j = i + 1;
+        while (j < n && Grid_keys[j] == Grid_keys[i]) { ++j; }
+
+        size_t slot = obj_grid_hash (Grid_keys[i]);
+        while (Grid_cells[slot & (size - 1)].key) { ++slot; }
+
+        slot &= size - 1;
+
+        Grid_cells[slot] = obj_grid_cell{ Grid_keys[i], int (i), int (j - i) };
+        Grid_used_cells.push_back (int (slot));
+
+        i = j;
+    }
+
+    Grid_valid = true;
+}
+
+/**
+ * True if a candidate is still the object that was seen at the build and has
+ * the wanted type and team
+ */
+static inline bool
+obj_grid_accept (int objnum, int type_mask, int iff_mask) {
+    object* objp = &Objects[objnum];
+
+    if (objp->signature != Grid_signature[objnum] ||
+        objp->type != Grid_type[objnum]) {
+        return false;
+    }
+
+    if (!(type_mask & OBJ_GRID_TYPE (objp->type))) { return false; }
+
+    if (iff_mask != OBJ_GRID_ALL_TEAMS) {
+        int team = obj_team (objp);
+        if (team < 0 || !(iff_mask & (1 << team))) { return false; }
+    }
+
+    return true;
+}
+
+/**
+ * Collects the objects for which test (pos, radius) holds, looking only at the
+ * cells that overlap the box [lo, hi]. The tests are given the positions from
+ * the build and radii widened by the motion margin.
+ */
+template< typename Test >
+static void obj_grid_gather (
+    const vec3d& lo, const vec3d& hi, int type_mask, int iff_mask, Test test,
+    std::vector< int >& objnums) {
+    objnums.clear ();
+
+    // the centers of the small objects can be this far out of the box
+    const float pad = OBJ_GRID_LARGE_RADIUS + Grid_margin;
+
+    const int x0 = obj_grid_coord (lo.xyz.x - pad);
+    const int y0 = obj_grid_coord (lo.xyz.y - pad);
+    const int z0 = obj_grid_coord (lo.xyz.z - pad);
+    const int x1 = obj_grid_coord (hi.xyz.x + pad);
+    const int y1 = obj_grid_coord (hi.xyz.y + pad);
+    const int z1 = obj_grid_coord (hi.xyz.z + pad);
+
+    const double span = double (x1 - x0 + 1) * double (y1 - y0 + 1) *
+                        double (z1 - z0 + 1);
+
+    if (!Grid_valid || span > double (Grid_used_cells.size ())) {
+        // no grid yet, or a query as large as the grid: test the live objects
+        object* objp;
+
+        for (objp = GET_FIRST (&obj_used_list);
+             objp != END_OF_LIST (&obj_used_list); objp = GET_NEXT (objp)) {
+            if (!(type_mask & OBJ_GRID_TYPE (objp->type))) { continue; }
+
+            if (iff_mask != OBJ_GRID_ALL_TEAMS) {
+                int team = obj_team (objp);
+                if (team < 0 || !(iff_mask & (1 << team))) { continue; }
+            }
+
+            if (test (objp->pos, obj_grid_bound (objp))) {
+                objnums.push_back (OBJ_INDEX (objp));
+            }
+        }
+
+        return;
+    }
+
+    std::vector< std::pair< int, int > > found;
+
+    auto consider = [&](int objnum) {
+        if (!obj_grid_accept (objnum, type_mask, iff_mask)) { return; }
+
+        if (test (Grid_pos[objnum], Grid_radius[objnum] + Grid_margin)) {
+            found.push_back (std::make_pair (Grid_rank[objnum], objnum));
+        }
+    };
+
+    for (short objnum : Grid_large) { consider (objnum); }
+
+    for (int x = x0; x <= x1; ++x) {
+        for (int y = y0; y <= y1; ++y) {
+            for (int z = z0; z <= z1; ++z) {
+                const obj_grid_cell* cell =
+                    obj_grid_find (obj_grid_key (x, y, z));
+
+                if (cell == NULL) { continue; }
+
+                for (int i = 0; i < cell->count; ++i) {
+                    consider (Grid_items[cell->first + i]);
+                }
+            }
+        }
+    }
+
+    // report the objects in the order of obj_used_list
+    std::sort (found.begin (), found.end ());
+
+    objnums.reserve (found.size ());
+    for (const auto& item : found) { objnums.push_back (item.second); }
+}
+
+void obj_grid_query_sphere (
+    const vec3d* center, float radius, int type_mask, int iff_mask,
+    std::vector< int >& objnums) {
+    ASSERT (center);
+
+    const vec3d c = *center;
+
+    vec3d lo = c, hi = c;
+    for (int i = 0; i < 3; ++i) {
+        lo.a1d[i] -= radius;
+        hi.a1d[i] += radius;
+    }
+
+    obj_grid_gather (
+        lo, hi, type_mask, iff_mask,
+        [&](const vec3d& pos, float r) {
+            const float reach = radius + r;
+            return vm_vec_dist_squared (&pos, &c) <= reach * reach;
+        },
+        objnums);
+}
+
+void obj_grid_query_box (
+    const vec3d* mins, const vec3d* maxs, int type_mask, int iff_mask,
+    std::vector< int >& objnums) {
+    ASSERT (mins && maxs);
+
+    const vec3d lo = *mins, hi = *maxs;
+
+    obj_grid_gather (
+        lo, hi, type_mask, iff_mask,
+        [&](const vec3d& pos, float r) {
+            float d = 0.0f;
+
+            for (int i = 0; i < 3; ++i) {
+                float x = pos.a1d[i];
+
+                if (x < lo.a1d[i]) { d += (lo.a1d[i] - x) * (lo.a1d[i] - x); }
+                else if (x > hi.a1d[i]) {
+                    d += (x - hi.a1d[i]) * (x - hi.a1d[i]);
+                }
+            }
+
+            return d <= r * r;
+        },
+        objnums);
+}
+
+void obj_grid_query_cone (
+    const vec3d* apex, const vec3d* axis, float cos_half_angle, float range,
+    int type_mask, int iff_mask, std::vector< int >& objnums) {
+    ASSERT (apex && axis);
+
+    const vec3d a = *apex, d = *axis;
+
+    // cones wider than a half space are only cut by the range
+    const float half_angle =
+        cos_half_angle > 0.0f
+            ? std::acos ((std::min) (cos_half_angle, 1.0f))
+            : PI;
+
+    vec3d lo = a, hi = a;
+    for (int i = 0; i < 3; ++i) {
+        lo.a1d[i] -= range;
+        hi.a1d[i] += range;
+    }
+
+    obj_grid_gather (
+        lo, hi, type_mask, iff_mask,
+        [&](const vec3d& pos, float r) {
+            vec3d v;
+            vm_vec_sub (&v, &pos, &a);
+
+            const float dist = vm_vec_mag (&v);
+
+            if (dist > range + r) { return false; }
+            if (dist <= r || half_angle >= PI) { return true; }
+
+            // the sphere is seen from the apex under asin (r / dist)
+            const float cos_angle = vm_vec_dot (&v, &d) / dist;
+            const float angle =
+                std::acos ((std::max) (-1.0f, (std::min) (1.0f, cos_angle)));
+
+            return angle <= half_angle + std::asin (r / dist);
+        },
+        objnums);
+}
@@ -0,0 +1,65 @@
+// -*- mode: c++; -*-
+
+#ifndef FREESPACE2_OBJECT_OBJECTGRID_HH
+#define FREESPACE2_OBJECT_OBJECTGRID_HH
+
+#include "defs.hh"
+#include "math/vecmat.hh"
+
+#include <vector>
+
+// A hashed uniform grid over the objects in obj_used_list, for the "what is
+// near this point" questions that used to scan every object.
+//
+// obj_move_all rebuilds the grid once per frame, right after the objects
+// created during the previous frame have been merged into obj_used_list, so a
+// query sees the same objects a scan of obj_used_list would. Objects keep
+// moving during the frame; the queries widen every test by the distance the
+// fastest object can have travelled since the build, so the result is a
+// superset of the objects whose exact distance passes the test at their live
+// positions. Callers re-test the candidates against the live object data,
+// exactly as they did in their scans.
+//
+// Queries that cover more cells than the grid uses scan obj_used_list.
+//
+// The results are object numbers in obj_used_list order, so a caller that
+// keeps the first best match breaks ties the way the old scan did. Objects
+// that died or were replaced since the build are dropped; objects created
+// since the build are not found until the next frame.
+
+// vm_vec_dist_quick underestimates distances by up to 10%; callers that test
+// their candidates with it scale the query range by this, so that the query
+// finds every object the quick test accepts
+#define OBJ_GRID_QUICK_DIST_SCALE (1.0f / 0.9f)
+
+// type masks for the queries
+#define OBJ_GRID_TYPE(type) (1 << (type))
+#define OBJ_GRID_ALL_TYPES (-1)
+
+// iff mask that matches every object, with or without a team
+#define OBJ_GRID_ALL_TEAMS (-1)
+
+// forgets the grid; the queries scan obj_used_list until the next build
+void obj_grid_reset ();
+
+// rebuilds the grid from obj_used_list; frametime bounds how far the objects
+// can move before the next build
+void obj_grid_build (float frametime);
+
+// objects whose bounding sphere overlaps the sphere
+void obj_grid_query_sphere (
+    const vec3d* center, float radius, int type_mask, int iff_mask,
+    std::vector< int >& objnums);
+
+// objects whose bounding sphere overlaps the box
+void obj_grid_query_box (
+    const vec3d* mins, const vec3d* maxs, int type_mask, int iff_mask,
+    std::vector< int >& objnums);
+
+// objects whose bounding sphere overlaps the cone with the apex, unit axis and
+// cosine of the half angle, cut off at range
+void obj_grid_query_cone (
+    const vec3d* apex, const vec3d* axis, float cos_half_angle, float range,
+    int type_mask, int iff_mask, std::vector< int >& objnums);
+
+#endif // FREESPACE2_OBJECT_OBJECTGRID_HH
@@ -20,6 +20,7 @@
 #include "ship/ship.hh"
 #include "weapon/weapon.hh"
 #include "mod_table/mod_table.hh"
+#include "tracing/MemoryAccount.hh"
 #include "util/encoding.hh"
 #include "util/unicode.hh"
 #include "assert/assert.hh"
@@ -53,6 +54,9 @@ static int Parsing_paused = 0;
 void allocate_parse_text (size_t size);
 static size_t Parse_text_size = 0;
 
+// Parse_text and Parse_text_raw, Parse_text_size bytes each
+static tracing::MemoryAccount Parse_text_memory ("Parse text");
+
 // Return true if this character is white space, else false.
 int is_white_space (char ch) {
     return ((ch == ' ') || (ch == '\t') || (ch == EOLN));
@@ -1822,6 +1826,7 @@ void stop_parse () {
     }
 
     Parse_text_size = 0;
+    Parse_text_memory.set (0, 0);
 }
 
 void allocate_parse_text (size_t size) {
@@ -1865,6 +1870,7 @@ void allocate_parse_text (size_t size) {
     memset (Parse_text_raw, 0, sizeof (char) * size);
 
     Parse_text_size = size;
+    Parse_text_memory.set (2 * size, 2);
 }
 
 // Goober5000
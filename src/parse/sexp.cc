@@ -75,6 +75,7 @@
 #include "starfield/starfield.hh"
 #include "starfield/supernova.hh"
 #include "stats/medals.hh"
+#include "tracing/MemoryAccount.hh"
 #include "util/list.hh"
 #include "util/unicode.hh"
 #include "weapon/beam.hh"
@@ -4098,6 +4099,13 @@ float Training_context_distance;
 int Num_sexp_nodes = 0;
 sexp_node* Sexp_nodes = NULL;
 
+static tracing::MemoryAccount Sexp_memory ("Sexp nodes");
+
+// Reports the size of the node array, called whenever it is reallocated
+static void sexp_nodes_update_memory () {
+    Sexp_memory.set (sizeof (sexp_node) * Num_sexp_nodes, Num_sexp_nodes);
+}
+
 sexp_variable Sexp_variables[MAX_SEXP_VARIABLES];
 sexp_variable
     Block_variables[MAX_SEXP_VARIABLES]; // used for compatibility with retail.
@@ -4321,6 +4329,8 @@ void sexp_nodes_init () {
         ASSERT (Sexp_nodes != NULL);
     }
 
+    sexp_nodes_update_memory ();
+
     WARNINGF (LOCATION, "Exited function with %d nodes.", Num_sexp_nodes);
 }
 
@@ -4330,6 +4340,8 @@ static void sexp_nodes_close () {
         free (Sexp_nodes);
         Sexp_nodes = NULL;
         Num_sexp_nodes = 0;
+
+        sexp_nodes_update_memory ();
     }
 }
 
@@ -4388,6 +4400,7 @@ int alloc_sexp (const char* text, int type, int subtype, int first, int rest) {
             Sexp_nodes, sizeof (sexp_node) * Num_sexp_nodes);
 
         ASSERT (Sexp_nodes != NULL);
+        sexp_nodes_update_memory ();
         WARNINGF (LOCATION, "Bumping dynamic sexp node limit from %d to %d...",old_size, Num_sexp_nodes);
 
         // clear all the new sexp nodes we just allocated
@@ -333,6 +333,12 @@ toggle_player_object (); // toggles between descent-style ship and player ship
 extern void read_player_controls (object* obj, float frametime);
 extern void player_control_reset_ci (control_info* ci);
 
+// records the controls read by read_player_controls to a file, one line per
+// frame stamped with the mission time, or replays such a file in their place
+bool player_controls_record (const char* filename);
+bool player_controls_replay (const char* filename);
+void player_controls_record_close ();
+
 void player_generate_death_message (player* player_p);
 void player_show_death_message ();
 void player_maybe_fire_turret (object* objp);
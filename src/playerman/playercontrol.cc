@@ -30,6 +30,9 @@
 #include "weapon/weapon.hh"
 #include "log/log.hh"
 
+#include <fstream>
+#include <iomanip>
+
 #ifndef NDEBUG
 #include "io/key.hh"
 #endif
@@ -1041,6 +1044,106 @@ void copy_control_info (control_info* dest_ci, control_info* src_ci) {
     }
 }
 
+// The control recording or replay in progress, see player_controls_record
+static std::ofstream Control_record;
+static std::ifstream Control_replay;
+
+static bool Control_replay_ahead = false; // a line has been read ahead
+static fix Control_replay_time;
+static control_info Control_replay_next;
+static control_info Control_replay_last;
+
+static void player_controls_write (std::ostream& out, const control_info* ci) {
+    out << Missiontime << ' ' << ci->pitch << ' ' << ci->vertical << ' '
+        << ci->heading << ' ' << ci->sideways << ' ' << ci->bank << ' '
+        << ci->forward << ' ' << ci->forward_cruise_percent << ' '
+        << ci->fire_primary_count << ' ' << ci->fire_secondary_count << ' '
+        << ci->fire_countermeasure_count << ' ' << ci->afterburner_start << ' '
+        << ci->afterburner_stop << '\n';
+}
+
+static bool
+player_controls_read (std::istream& in, fix* time, control_info* ci) {
+    memset (ci, 0, sizeof *ci);
+
+    return bool (
+        in >> *time >> ci->pitch >> ci->vertical >> ci->heading >>
+        ci->sideways >> ci->bank >> ci->forward >> ci->forward_cruise_percent >>
+        ci->fire_primary_count >> ci->fire_secondary_count >>
+        ci->fire_countermeasure_count >> ci->afterburner_start >>
+        ci->afterburner_stop);
+}
+
+bool player_controls_record (const char* filename) {
+    player_controls_record_close ();
+
+    Control_record.open (filename, std::ios::out | std::ios::trunc);
+
+    if (!Control_record) {
+        WARNINGF (LOCATION, "Cannot record the controls to %s", filename);
+        return false;
+    }
+
+    // enough digits to read back the same floats
+    Control_record << std::setprecision (9);
+
+    return true;
+}
+
+bool player_controls_replay (const char* filename) {
+    player_controls_record_close ();
+
+    Control_replay.open (filename);
+
+    if (!Control_replay) {
+        WARNINGF (LOCATION, "Cannot replay the controls from %s", filename);
+        return false;
+    }
+
+    memset (&Control_replay_last, 0, sizeof Control_replay_last);
+
+    Control_replay_ahead = player_controls_read (
+        Control_replay, &Control_replay_time, &Control_replay_next);
+
+    return true;
+}
+
+void player_controls_record_close () {
+    if (Control_record.is_open ()) { Control_record.close (); }
+    if (Control_replay.is_open ()) { Control_replay.close (); }
+
+    Control_replay_ahead = false;
+}
+
+/**
+ * Replaces the controls with the recorded ones up to the current mission
+ * time. The axes come from the last line passed, the one-shot presses from
+ * all of them, so the replay also works at a frame rate other than the one
+ * of the recording.
+ */
+static void player_controls_replay_frame (control_info* ci) {
+    int secondary = 0, countermeasure = 0, burner_start = 0, burner_stop = 0;
+
+    while (Control_replay_ahead && Control_replay_time <= Missiontime) {
+        Control_replay_last = Control_replay_next;
+
+        secondary |= Control_replay_next.fire_secondary_count;
+        countermeasure |= Control_replay_next.fire_countermeasure_count;
+        burner_start |= Control_replay_next.afterburner_start;
+        burner_stop |= Control_replay_next.afterburner_stop;
+
+        Control_replay_ahead = player_controls_read (
+            Control_replay, &Control_replay_time, &Control_replay_next);
+    }
+
+    *ci = Control_replay_last;
+
+    ci->fire_secondary_count = secondary;
+    ci->fire_countermeasure_count = countermeasure;
+    ci->afterburner_start = burner_start;
+    ci->afterburner_stop = burner_stop;
+}
+
 void read_player_controls (object* objp, float frametime) {
     float diff;
     float target_warpout_speed;
@@ -1053,6 +1156,13 @@ void read_player_controls (object* objp, float frametime) {
     case PCM_NORMAL:
         read_keyboard_controls (&(Player->ci), frametime, &objp->phys_info);
 
+        if (Control_replay.is_open ()) {
+            player_controls_replay_frame (&(Player->ci));
+        }
+        else if (Control_record.is_open ()) {
+            player_controls_write (Control_record, &(Player->ci));
+        }
+
         if (lua_game_control & LGC_STEERING) {
             // make sure to copy the control before reseting it
             Player->lua_ci = Player->ci;
@@ -13,6 +13,7 @@
 #include "sound/dscap.hh"
 #include "sound/openal.hh"
 #include "sound/sound.hh" // jg18 - for enhanced sound
+#include "tracing/MemoryAccount.hh"
 #include "assert/assert.hh"
 #include "log/log.hh"
 
@@ -38,6 +39,9 @@ static int channel_next_sig = 1;
 const int BUFFER_BUMP = 50;
 std::vector< sound_buffer > sound_buffers;
 
+// The bytes of the OpenAL buffers, by their size in nbytes
+static tracing::MemoryAccount Sound_memory ("Sound buffers");
+
 static int Ds_use_eax = 0;
 
 static int Ds_eax_inited = 0;
@@ -528,6 +532,8 @@ int ds_load_buffer (int* sid, int /*flags*/, ffmpeg::WaveFile* file) {
     sound_buffers[*sid].nseconds = int (file->getDuration ());
     sound_buffers[*sid].nbytes = (int)audio_buffer.size ();
 
+    Sound_memory.add (audio_buffer.size ());
+
     return 0;
 }
 
@@ -843,7 +849,10 @@ void ds_unload_buffer (int sid) {
         OpenAL_ErrorCheck (alDeleteBuffers (1, &buf_id), return );
     }
 
+    if (buf_id != 0) { Sound_memory.remove (sound_buffers[sid].nbytes); }
+
     sound_buffers[sid].buf_id = 0;
+    sound_buffers[sid].nbytes = 0;
 }
 
 /**
@@ -1233,6 +1242,8 @@ int ds_create_buffer (
     sound_buffers[sid].nbytes =
         nseconds * (bits_per_sample / 8) * nchannels * frequency;
 
+    Sound_memory.add (sound_buffers[sid].nbytes);
+
     return sid;
 }
 
@@ -1247,6 +1258,9 @@ int ds_lock_data (int sid, unsigned char* data, int size) {
 
     if (format == AL_INVALID_VALUE) { return -1; }
 
+    Sound_memory.remove (sound_buffers[sid].nbytes, 0);
+    Sound_memory.add (size, 0);
+
     sound_buffers[sid].nbytes = size;
 
     OpenAL_ErrorCheck (
@@ -637,13 +637,20 @@ int targa_read_bitmap (
 
     ASSERT (bytes_remaining > 0);
 
-    ubyte* fileptr = (ubyte*)malloc (bytes_remaining);
-    ASSERT (fileptr);
-    if (fileptr == NULL) { return TARGA_ERROR_READING; }
+    // Files in memory are decoded in place, the pixel data only is read
+    size_t span_size = 0;
+    ubyte* fileptr = NULL;
+    ubyte* src_pixels = (ubyte*)cf_returndata_span (targa_file, &span_size);
 
-    ubyte* src_pixels = fileptr;
+    if (src_pixels == NULL || span_size < size_t (bytes_remaining)) {
+        fileptr = (ubyte*)malloc (bytes_remaining);
+        ASSERT (fileptr);
+        if (fileptr == NULL) { return TARGA_ERROR_READING; }
 
-    cfread (fileptr, bytes_remaining, 1, targa_file);
+        src_pixels = fileptr;
+
+        cfread (fileptr, bytes_remaining, 1, targa_file);
+    }
 
     int rowsize = header.width * dest_size;
 
@@ -0,0 +1,198 @@
+// -*- mode: c++; -*-
+
+#include "defs.hh"
+
+//
+// Converts a binary trace written with -profile_trace into the Chrome
+// trace event JSON format, which chrome://tracing and Perfetto can load.
+//
+// usage: traceconvert <trace file> [<json file>]
+//
+
+#include "tracing/TraceFormat.hh"
+#include "tracing/tracing.hh"
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace tracing;
+
+static const char* event_phase (std::uint8_t type) {
+    switch (EventType (type)) {
+    case EventType::Complete: return "X";
+    case EventType::Begin: return "B";
+    case EventType::End: return "E";
+    case EventType::AsyncBegin: return "b";
+    case EventType::AsyncStep: return "n";
+    case EventType::AsyncEnd: return "e";
+    case EventType::Counter: return "C";
+    default: return nullptr;
+    }
+}
+
+// nanoseconds to the microseconds of the JSON format
+static void write_time (FILE* out, std::uint64_t time) {
+    fprintf (out, "%" PRIu64 ".%03u", time / 1000, unsigned (time % 1000));
+}
+
+// the names are ours, only quotes and backslashes need escaping
+static void write_string (FILE* out, const std::string& str) {
+    fputc ('"', out);
+
+    for (auto c : str) {
+        if (c == '"' || c == '\\') { fputc ('\\', out); }
+        fputc (c, out);
+    }
+
+    fputc ('"', out);
+}
+
+static const std::string&
+lookup (const std::vector< std::string >& names, std::uint32_t id) {
+    static const std::string unknown = "unknown";
+    return id < names.size () ? names[id] : unknown;
+}
+
+static void write_event (
+    FILE* out, const format::event& evt,
+    const std::vector< std::string >& names) {
+    const char* phase = event_phase (evt.type);
+
+    fprintf (out, "{\"tid\":%" PRId64 ",\"ts\":", evt.tid);
+    write_time (out, evt.timestamp);
+
+    if (evt.pid == GPU_PID) { fputs (",\"pid\":\"GPU\"", out); }
+    else {
+        fprintf (out, ",\"pid\":%" PRId64, evt.pid);
+    }
+
+    if (evt.scope) {
+        fputs (",\"cat\":", out);
+        write_string (out, lookup (names, evt.scope));
+        fprintf (out, ",\"id\":\"0x%" PRIx32 "\"", evt.scope);
+    }
+
+    fputs (",\"name\":", out);
+    write_string (out, lookup (names, evt.category));
+    fprintf (out, ",\"ph\":\"%s\"", phase);
+
+    switch (EventType (evt.type)) {
+    case EventType::Complete:
+        fputs (",\"dur\":", out);
+        write_time (out, evt.duration);
+        break;
+    case EventType::Counter:
+        fprintf (out, ",\"args\":{\"value\":%f}", evt.value);
+        break;
+    default: break;
+    }
+
+    fputc ('}', out);
+}
+
+static int convert (FILE* in, FILE* out) {
+    format::file_header header;
+
+    if (1 != fread (&header, sizeof header, 1, in) ||
+        memcmp (header.magic, format::magic, sizeof header.magic)) {
+        fprintf (stderr, "not a trace file\n");
+        return 1;
+    }
+
+    if (header.version != format::version) {
+        fprintf (
+            stderr, "unsupported trace version %" PRIu32 "\n", header.version);
+        return 1;
+    }
+
+    std::vector< std::string > names (1);
+    size_t count = 0;
+    bool truncated = false;
+
+    fputs ("[", out);
+
+    for (int tag; EOF != (tag = fgetc (in));) {
+        ungetc (tag, in);
+
+        if (tag == format::name_record) {
+            format::name_header name;
+
+            if (1 != fread (&name, sizeof name, 1, in)) {
+                truncated = true;
+                break;
+            }
+
+            std::string str (name.length, '\0');
+
+            if (name.length && 1 != fread (&str[0], name.length, 1, in)) {
+                truncated = true;
+                break;
+            }
+
+            if (names.size () <= name.id) { names.resize (name.id + 1); }
+            names[name.id] = str;
+        }
+        else if (tag == format::event_record) {
+            format::event evt;
+
+            if (1 != fread (&evt, sizeof evt, 1, in)) {
+                truncated = true;
+                break;
+            }
+
+            if (!event_phase (evt.type)) {
+                fprintf (stderr, "skipping event of unknown type\n");
+                continue;
+            }
+
+            fputs (count++ ? ",\n" : "\n", out);
+            write_event (out, evt, names);
+        }
+        else {
+            fprintf (stderr, "corrupt record, stopping\n");
+            truncated = true;
+            break;
+        }
+    }
+
+    fputs ("\n]\n", out);
+
+    if (truncated) { fprintf (stderr, "the trace file is truncated\n"); }
+
+    fprintf (stderr, "%zu events\n", count);
+
+    return 0;
+}
+
+int main (int argc, char** argv) {
+    if (argc < 2 || argc > 3) {
+        fprintf (stderr, "usage: %s <trace file> [<json file>]\n", argv[0]);
+        return 1;
+    }
+
+    FILE* in = fopen (argv[1], "rb");
+
+    if (!in) {
+        fprintf (stderr, "cannot open %s: %s\n", argv[1], strerror (errno));
+        return 1;
+    }
+
+    FILE* out = argc > 2 ? fopen (argv[2], "w") : stdout;
+
+    if (!out) {
+        fprintf (stderr, "cannot open %s: %s\n", argv[2], strerror (errno));
+        fclose (in);
+        return 1;
+    }
+
+    const int result = convert (in, out);
+
+    fclose (in);
+    if (out != stdout) { fclose (out); }
+
+    return result;
+}
@@ -0,0 +1,188 @@
+// -*- mode: c++; -*-
+
+#include "defs.hh"
+
+#include "tracing/AllocationTracker.hh"
+#include "tracing/tracing.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <deque>
+#include <new>
+#include <string>
+
+namespace {
+
+using namespace tracing;
+using namespace tracing::allocations;
+
+std::atomic< bool > tracking{ false };
+
+// The counts of the current frame, by category index; index 0 counts the
+// allocations outside of any category and those of the categories beyond
+// MAX_CATEGORIES
+struct counts {
+    std::atomic< std::uint64_t > count;
+    std::atomic< std::uint64_t > bytes;
+    std::atomic< std::uint64_t > frees;
+    std::atomic< const Category* > category;
+};
+
+counts frame_counts[MAX_CATEGORIES];
+
+std::vector< category_allocations > last_frame_counts;
+
+// The counter categories of the categories seen allocating, by index. The
+// counters are created on the main thread only, in process_frame.
+std::deque< std::string > counter_names;
+std::deque< Category > counter_categories;
+const Category* byte_counters[MAX_CATEGORIES];
+
+counts& current_counts () {
+    const Category* category = current_category ();
+    const int index = category ? category->getIndex () : 0;
+
+    auto& slot = frame_counts[index];
+
+    if (index && !slot.category.load (std::memory_order_relaxed)) {
+        slot.category.store (category, std::memory_order_relaxed);
+    }
+
+    return slot;
+}
+
+void count_allocation (size_t size) {
+    auto& slot = current_counts ();
+
+    slot.count.fetch_add (1, std::memory_order_relaxed);
+    slot.bytes.fetch_add (size, std::memory_order_relaxed);
+}
+
+void count_free () {
+    current_counts ().frees.fetch_add (1, std::memory_order_relaxed);
+}
+
+void* allocate (size_t size) {
+    void* ptr;
+
+    while (!(ptr = malloc (size ? size : 1))) {
+        auto handler = std::get_new_handler ();
+        if (!handler) { throw std::bad_alloc (); }
+        handler ();
+    }
+
+    if (tracking.load (std::memory_order_relaxed)) { count_allocation (size); }
+
+    return ptr;
+}
+
+void deallocate (void* ptr) {
+    if (ptr && tracking.load (std::memory_order_relaxed)) { count_free (); }
+
+    free (ptr);
+}
+
+const Category* byte_counter_of (int index, const Category* category) {
+    if (!byte_counters[index]) {
+        counter_names.push_back (
+            std::string ("Allocated bytes: ") +
+            (category ? category->getName () : "none"));
+        counter_categories.emplace_back (counter_names.back ().c_str (), false);
+
+        byte_counters[index] = &counter_categories.back ();
+    }
+
+    return byte_counters[index];
+}
+
+} // namespace
+
+// The replacements of the global allocation functions; the aligned ones are
+// left alone and not counted.
+void* operator new (size_t size) { return allocate (size); }
+void* operator new[] (size_t size) { return allocate (size); }
+
+void* operator new (size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return allocate (size);
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[] (size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return allocate (size);
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete (void* ptr) noexcept { deallocate (ptr); }
+void operator delete[] (void* ptr) noexcept { deallocate (ptr); }
+void operator delete (void* ptr, size_t) noexcept { deallocate (ptr); }
+void operator delete[] (void* ptr, size_t) noexcept { deallocate (ptr); }
+
+void operator delete (void* ptr, const std::nothrow_t&) noexcept {
+    deallocate (ptr);
+}
+
+void operator delete[] (void* ptr, const std::nothrow_t&) noexcept {
+    deallocate (ptr);
+}
+
+namespace tracing {
+namespace allocations {
+
+void enable () { tracking.store (true, std::memory_order_relaxed); }
+
+bool enabled () { return tracking.load (std::memory_order_relaxed); }
+
+void process_frame () {
+    std::vector< category_allocations > frame;
+
+    category_allocations total;
+
+    for (int i = 0; i < MAX_CATEGORIES; ++i) {
+        auto& slot = frame_counts[i];
+
+        category_allocations item;
+
+        item.category = slot.category.load (std::memory_order_relaxed);
+        item.count = slot.count.exchange (0, std::memory_order_relaxed);
+        item.bytes = slot.bytes.exchange (0, std::memory_order_relaxed);
+        item.frees = slot.frees.exchange (0, std::memory_order_relaxed);
+
+        if (!item.count && !item.frees) { continue; }
+
+        total.count += item.count;
+        total.bytes += item.bytes;
+        total.frees += item.frees;
+
+        counter::value (*byte_counter_of (i, item.category), item.bytes);
+
+        frame.push_back (item);
+    }
+
+    counter::value (Allocations, total.count);
+    counter::value (AllocatedBytes, total.bytes);
+    counter::value (Frees, total.frees);
+
+    std::sort (
+        frame.begin (), frame.end (),
+        [](const category_allocations& lhs, const category_allocations& rhs) {
+            return lhs.bytes > rhs.bytes;
+        });
+
+    last_frame_counts = std::move (frame);
+}
+
+std::vector< category_allocations > last_frame () {
+    return last_frame_counts;
+}
+
+} // namespace allocations
+} // namespace tracing
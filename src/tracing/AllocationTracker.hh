@@ -0,0 +1,60 @@
+// -*- mode: c++; -*-
+
+#ifndef FREESPACE2_TRACING_ALLOCATIONTRACKER_HH
+#define FREESPACE2_TRACING_ALLOCATIONTRACKER_HH
+
+#include "defs.hh"
+
+#include "tracing/categories.hh"
+
+#include <vector>
+
+/** @file
+ *  @ingroup tracing
+ *
+ *  Counts the heap allocations made through operator new, per frame and per
+ * tracing category. An allocation is attributed to the innermost complete
+ * event open on the allocating thread, or to no category outside of any.
+ * Frees are attributed the same way, to the category that frees.
+ */
+
+namespace tracing {
+namespace allocations {
+
+/**
+ * @brief The allocations of one category during a frame
+ */
+struct category_allocations {
+    const Category* category = nullptr; // nullptr outside of any category
+
+    std::uint64_t count = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t frees = 0;
+};
+
+/**
+ * @brief Starts counting the allocations
+ */
+void enable ();
+
+/**
+ * @brief Whether the allocations are being counted
+ */
+bool enabled ();
+
+/**
+ * @brief Ends the frame: submits its allocations as counter events and keeps
+ * them for last_frame
+ */
+void process_frame ();
+
+/**
+ * @brief Gets the allocations of the last frame ended by process_frame, the
+ * most bytes first
+ */
+std::vector< category_allocations > last_frame ();
+
+} // namespace allocations
+} // namespace tracing
+
+#endif // FREESPACE2_TRACING_ALLOCATIONTRACKER_HH
@@ -0,0 +1,99 @@
+// -*- mode: c++; -*-
+
+#include "defs.hh"
+
+#include "tracing/FlightRecorder.hh"
+#include "tracing/TraceEventWriter.hh"
+#include "log/log.hh"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace tracing {
+
+FlightRecorder::FlightRecorder (
+    const char* prefix, std::uint64_t window, std::uint64_t budget)
+    : _prefix (prefix), _window (window), _budget (budget),
+      _events (max_events) {}
+
+void FlightRecorder::push (const trace_event* event) {
+    if (_count == max_events) {
+        // The ring is full, the oldest event makes room
+        _first = (_first + 1) % max_events;
+        --_count;
+    }
+
+    _events[(_first + _count) % max_events] = *event;
+    ++_count;
+
+    // GPU timestamps have their own origin, only the CPU ones age the window
+    if (event->pid != GPU_PID) {
+        _newest = (std::max) (_newest, event->timestamp);
+    }
+
+    // GPU events leave with the first CPU event recorded after them
+    for (;;) {
+        size_t n = 0;
+        while (n < _count && at (n).pid == GPU_PID) { ++n; }
+
+        if (n == _count || at (n).timestamp + _window >= _newest) { break; }
+
+        _first = (_first + n + 1) % max_events;
+        _count -= n + 1;
+    }
+}
+
+void FlightRecorder::dump (const char* reason) {
+    const auto filename = _prefix + "." + std::to_string (++_dumps);
+
+    {
+        TraceEventWriter writer (filename.c_str ());
+
+        for (size_t i = 0; i < _count; ++i) { writer.processEvent (&at (i)); }
+    }
+
+    II << "flight recorder: " << reason << ", wrote " << _count
+       << " events to " << filename;
+}
+
+void FlightRecorder::processEvent (const trace_event* event) {
+    push (event);
+
+    if (event->scope == &MainFrameScope && event->category == &MainFrame) {
+        if (event->type == EventType::AsyncBegin) {
+            _frame_begin = event->timestamp;
+        }
+        else if (event->type == EventType::AsyncEnd && _frame_begin) {
+            const auto duration = event->timestamp - _frame_begin;
+            const auto budget = _budget.load (std::memory_order_relaxed);
+
+            _frame_begin = 0;
+
+            if (budget && duration > budget &&
+                (!_last_spike || event->timestamp - _last_spike >= _window)) {
+                _last_spike = event->timestamp;
+
+                char buf[64];
+                snprintf (
+                    buf, sizeof buf, "frame of %.3f ms",
+                    double (duration) / 1e6);
+
+                dump (buf);
+            }
+        }
+    }
+
+    if (_dump_requested.exchange (false, std::memory_order_relaxed)) {
+        dump ("dump requested");
+    }
+}
+
+void FlightRecorder::setBudget (std::uint64_t budget) {
+    _budget.store (budget, std::memory_order_relaxed);
+}
+
+void FlightRecorder::requestDump () {
+    _dump_requested.store (true, std::memory_order_relaxed);
+}
+
+} // namespace tracing
@@ -0,0 +1,89 @@
+// -*- mode: c++; -*-
+
+#ifndef FREESPACE2_TRACING_FLIGHTRECORDER_HH
+#define FREESPACE2_TRACING_FLIGHTRECORDER_HH
+
+#include "defs.hh"
+
+#include "tracing/tracing.hh"
+#include "tracing/ThreadedEventProcessor.hh"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+/** @file
+ *  @ingroup tracing
+ */
+
+namespace tracing {
+
+/**
+ * @brief Keeps the events of the last few seconds in memory and writes them
+ * to a trace file when a frame goes over budget
+ *
+ * The events are kept in a bounded ring, oldest first, and dropped once they
+ * are older than the window. A main frame longer than the budget, or a dump
+ * request, writes the whole ring in the format of TraceEventWriter to a new
+ * file named after the prefix and the number of the dump. After a spike the
+ * next one is only dumped once a full window has passed, so that a run of
+ * slow frames does not write a file each.
+ */
+class FlightRecorder {
+public:
+    // enough for a few seconds of frame level events
+    static const size_t max_events = 1 << 18;
+
+private:
+    std::string _prefix;
+
+    std::uint64_t _window;
+    std::atomic< std::uint64_t > _budget;
+
+    std::atomic< bool > _dump_requested{ false };
+
+    std::vector< trace_event > _events;
+    size_t _first = 0;
+    size_t _count = 0;
+
+    std::uint64_t _newest = 0;
+    std::uint64_t _frame_begin = 0;
+
+    int _dumps = 0;
+    std::uint64_t _last_spike = 0;
+
+    const trace_event& at (size_t i) const {
+        return _events[(_first + i) % max_events];
+    }
+
+    void push (const trace_event* event);
+    void dump (const char* reason);
+
+public:
+    /**
+     * @param prefix The prefix of the names of the dumped files
+     * @param window How far back the events are kept, in nanoseconds
+     * @param budget The frame time budget in nanoseconds, 0 for none
+     */
+    FlightRecorder (
+        const char* prefix, std::uint64_t window, std::uint64_t budget);
+
+    void processEvent (const trace_event* event);
+
+    /**
+     * @brief Sets the frame time budget, from any thread
+     */
+    void setBudget (std::uint64_t budget);
+
+    /**
+     * @brief Dumps the window with the next event processed, from any thread
+     */
+    void requestDump ();
+};
+
+typedef ThreadedEventProcessor< FlightRecorder, 1 << 16 >
+    ThreadedFlightRecorder;
+
+} // namespace tracing
+
+#endif // FREESPACE2_TRACING_FLIGHTRECORDER_HH
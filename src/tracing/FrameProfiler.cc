@@ -2,9 +2,12 @@
 
 #include "defs.hh"
 
+#include <cinttypes>
+
 #include "math/fix.hh"
 #include "math/floating.hh"
 #include "shared/globals.hh"
+#include "tracing/AllocationTracker.hh"
 #include "tracing/FrameProfiler.hh"
 
 using namespace tracing;
@@ -280,6 +283,21 @@ void FrameProfiler::dump_output (
     }
 }
 
+void FrameProfiler::dump_allocations (std::stringstream& out) {
+    out << "\n Allocs :    Bytes : Frees : Allocating Category\n";
+    out << "---------------------------------------------\n";
+
+    for (const auto& item : allocations::last_frame ()) {
+        char line[256];
+        sprintf (
+            line, "%7" PRIu64 " : %8" PRIu64 " : %5" PRIu64 " : ", item.count,
+            item.bytes, item.frees);
+
+        out << line << (item.category ? item.category->getName () : "(none)")
+            << "\n";
+    }
+}
+
 std::string FrameProfiler::getContent () { return content; }
 void FrameProfiler::processFrame () {
     std::lock_guard< std::mutex > vectorGuard (_eventsMutex);
@@ -315,6 +333,8 @@ void FrameProfiler::processFrame () {
 
     dump_output (stream, start_profile_time, end_profile_time, samples);
 
+    if (allocations::enabled ()) { dump_allocations (stream); }
+
     content = stream.str ();
 }
 
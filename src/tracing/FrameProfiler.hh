@@ -76,6 +76,8 @@ class FrameProfiler {
         std::stringstream& out, uint64_t start_profile_time,
         uint64_t end_profile_time, std::vector< profile_sample >& samples);
 
+    void dump_allocations (std::stringstream& out);
+
 public:
     FrameProfiler ();
     ~FrameProfiler ();
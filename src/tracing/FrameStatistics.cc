@@ -0,0 +1,205 @@
+// -*- mode: c++; -*-
+
+#include "defs.hh"
+
+#include "tracing/FrameStatistics.hh"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+using namespace tracing;
+
+const size_t sub_count = size_t (1) << duration_histogram::sub_bits;
+
+// direct buckets, then one group of sub buckets per power of two
+const size_t bucket_count =
+    (duration_histogram::max_bits - duration_histogram::sub_bits + 1) *
+    sub_count;
+
+unsigned most_significant_bit (std::uint64_t value) {
+    unsigned bit = 0;
+    while (value >>= 1) { ++bit; }
+    return bit;
+}
+
+const double percentiles[] = { 50., 90., 99., 99.9 };
+
+double to_ms (std::uint64_t ns) { return double (ns) / 1e6; }
+
+void append_line (
+    std::string& out, const char* name, const duration_histogram& histogram) {
+    char buf[256];
+
+    snprintf (
+        buf, sizeof buf,
+        "%-28.28s %8" PRIu64 " %9.3f %9.3f %9.3f %9.3f %9.3f %9.3f\n", name,
+        histogram.count (), to_ms (histogram.mean ()),
+        to_ms (histogram.percentile (percentiles[0])),
+        to_ms (histogram.percentile (percentiles[1])),
+        to_ms (histogram.percentile (percentiles[2])),
+        to_ms (histogram.percentile (percentiles[3])),
+        to_ms (histogram.max ()));
+
+    out += buf;
+}
+
+} // namespace
+
+namespace tracing {
+
+duration_histogram::duration_histogram () : _buckets (bucket_count) {}
+
+size_t duration_histogram::bucket_of (std::uint64_t value) {
+    const auto msb = most_significant_bit (value);
+
+    if (msb < sub_bits) { return size_t (value); }
+
+    if (msb >= max_bits) { return bucket_count - 1; }
+
+    // the sub_bits bits below the most significant one pick the bucket
+    // within the group of the power of two
+    const size_t group = msb - sub_bits + 1;
+    const size_t sub = size_t (value >> (msb - sub_bits)) - sub_count;
+
+    return group * sub_count + sub;
+}
+
+std::uint64_t duration_histogram::highest_of (size_t bucket) {
+    const size_t group = bucket / sub_count;
+    const size_t sub = bucket % sub_count;
+
+    if (group == 0) { return sub; }
+
+    const auto width = std::uint64_t (1) << (group - 1);
+    return (sub_count + sub) * width + width - 1;
+}
+
+void duration_histogram::record (std::uint64_t value) {
+    ++_buckets[bucket_of (value)];
+
+    _min = _count ? (std::min) (_min, value) : value;
+    _max = (std::max) (_max, value);
+
+    ++_count;
+    _total += value;
+}
+
+void duration_histogram::reset () {
+    std::fill (_buckets.begin (), _buckets.end (), 0);
+    _count = _total = _min = _max = 0;
+}
+
+std::uint64_t duration_histogram::percentile (double percent) const {
+    if (_count == 0) { return 0; }
+
+    const auto rank = (std::max) (
+        std::uint64_t (1),
+        std::uint64_t (std::ceil (percent / 100. * double (_count))));
+
+    std::uint64_t seen = 0;
+    size_t i = 0;
+
+    for (; i < _buckets.size (); ++i) {
+        seen += _buckets[i];
+
+        if (seen >= rank) { break; }
+    }
+
+    // the last bucket also holds everything beyond its range
+    if (seen < rank || i + 1 == _buckets.size ()) { return _max; }
+
+    return (std::max) (_min, (std::min) (highest_of (i), _max));
+}
+
+FrameStatistics::FrameStatistics (std::uint64_t budget) : _budget (budget) {}
+
+void FrameStatistics::processEvent (const trace_event* event) {
+    if (event->pid == GPU_PID) { return; }
+
+    std::lock_guard< std::mutex > guard (_mutex);
+
+    switch (event->type) {
+    case EventType::Complete:
+        _categories[event->category].record (event->duration);
+        break;
+
+    case EventType::AsyncBegin:
+        if (event->scope == &MainFrameScope && event->category == &MainFrame) {
+            _frame_begin = event->timestamp;
+        }
+        break;
+
+    case EventType::AsyncEnd:
+        if (event->scope == &MainFrameScope && event->category == &MainFrame &&
+            _frame_begin) {
+            const auto duration = event->timestamp - _frame_begin;
+
+            _frames.record (duration);
+            if (duration > _budget) { ++_frames_over_budget; }
+
+            _frame_begin = 0;
+        }
+        break;
+
+    default: break;
+    }
+}
+
+void FrameStatistics::setBudget (std::uint64_t budget) {
+    std::lock_guard< std::mutex > guard (_mutex);
+    _budget = budget;
+}
+
+void FrameStatistics::reset () {
+    std::lock_guard< std::mutex > guard (_mutex);
+
+    _frames.reset ();
+    _frames_over_budget = 0;
+    _frame_begin = 0;
+
+    _categories.clear ();
+}
+
+std::string FrameStatistics::getSummary () {
+    std::lock_guard< std::mutex > guard (_mutex);
+
+    std::string out;
+    char buf[256];
+
+    snprintf (
+        buf, sizeof buf, "%-28s %8s %9s %9s %9s %9s %9s %9s\n", "(ms)",
+        "count", "mean", "p50", "p90", "p99", "p99.9", "max");
+    out += buf;
+
+    append_line (out, "frame", _frames);
+
+    std::vector< std::pair< const Category*, const duration_histogram* > >
+        sorted;
+
+    for (const auto& item : _categories) {
+        sorted.emplace_back (item.first, &item.second);
+    }
+
+    std::sort (sorted.begin (), sorted.end (), [](auto& lhs, auto& rhs) {
+        return lhs.second->total () > rhs.second->total ();
+    });
+
+    for (const auto& item : sorted) {
+        append_line (out, item.first->getName (), *item.second);
+    }
+
+    snprintf (
+        buf, sizeof buf,
+        "%" PRIu64 " of %" PRIu64 " frames over the %.3f ms budget (%.2f%%)\n",
+        _frames_over_budget, _frames.count (), to_ms (_budget),
+        _frames.count () ? 100. * _frames_over_budget / _frames.count () : 0.);
+    out += buf;
+
+    return out;
+}
+
+} // namespace tracing
@@ -0,0 +1,106 @@
+// -*- mode: c++; -*-
+
+#ifndef FREESPACE2_TRACING_FRAMESTATISTICS_HH
+#define FREESPACE2_TRACING_FRAMESTATISTICS_HH
+
+#include "defs.hh"
+
+#include "tracing.hh"
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** @file
+ *  @ingroup tracing
+ */
+
+namespace tracing {
+
+/**
+ * @brief A histogram of durations with a bounded relative error
+ *
+ * The buckets are laid out like those of an HDR histogram: durations below
+ * 2^sub_bits nanoseconds each get a bucket, every power of two above that is
+ * split into 2^sub_bits buckets of equal width. A bucket is never wider than
+ * 1/2^sub_bits of the values it holds, so a percentile is accurate to about
+ * 1.6% whatever its magnitude. Durations beyond 2^max_bits nanoseconds, about
+ * 18 minutes, are counted in the last bucket.
+ */
+class duration_histogram {
+public:
+    static const unsigned sub_bits = 6;
+    static const unsigned max_bits = 40;
+
+private:
+    std::vector< std::uint64_t > _buckets;
+
+    std::uint64_t _count = 0;
+    std::uint64_t _total = 0;
+    std::uint64_t _min = 0;
+    std::uint64_t _max = 0;
+
+    static size_t bucket_of (std::uint64_t value);
+    static std::uint64_t highest_of (size_t bucket);
+
+public:
+    duration_histogram ();
+
+    void record (std::uint64_t value);
+    void reset ();
+
+    std::uint64_t count () const { return _count; }
+    std::uint64_t total () const { return _total; }
+    std::uint64_t min () const { return _min; }
+    std::uint64_t max () const { return _max; }
+
+    std::uint64_t mean () const { return _count ? _total / _count : 0; }
+
+    /**
+     * @brief The smallest duration that percent of the recorded durations do
+     * not exceed, within the precision of the buckets
+     */
+    std::uint64_t percentile (double percent) const;
+};
+
+/**
+ * @brief Streaming statistics of the main frame and of every category
+ *
+ * The main frame is measured from the asynchronous MainFrame events, the
+ * categories from their complete events on any thread. The frames longer
+ * than the budget are counted separately.
+ */
+class FrameStatistics {
+    std::mutex _mutex;
+
+    duration_histogram _frames;
+    std::uint64_t _frames_over_budget = 0;
+    std::uint64_t _budget = 0;
+
+    std::uint64_t _frame_begin = 0;
+
+    std::unordered_map< const Category*, duration_histogram > _categories;
+
+public:
+    /**
+     * @param budget The frame time budget in nanoseconds
+     */
+    explicit FrameStatistics (std::uint64_t budget);
+
+    void processEvent (const trace_event* event);
+
+    void setBudget (std::uint64_t budget);
+
+    void reset ();
+
+    /**
+     * @brief Formats the main frame statistics followed by those of the
+     * categories, the most expensive in total first
+     */
+    std::string getSummary ();
+};
+
+} // namespace tracing
+
+#endif // FREESPACE2_TRACING_FRAMESTATISTICS_HH
@@ -0,0 +1,147 @@
+// -*- mode: c++; -*-
+
+#include "defs.hh"
+
+#include "tracing/MemoryAccount.hh"
+#include "tracing/tracing.hh"
+#include "debugconsole/console.hh"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+
+namespace {
+
+using namespace tracing;
+
+// Constant initialized, so that accounts of any translation unit can register
+// during the static initialization
+std::atomic< MemoryAccount* > first_account{ nullptr };
+
+Category TotalMemory ("Memory: total", false);
+
+double to_mb (std::int64_t bytes) { return double (bytes) / (1024. * 1024.); }
+
+void update_max (std::atomic< std::int64_t >& max, std::int64_t value) {
+    auto current = max.load (std::memory_order_relaxed);
+
+    while (current < value &&
+           !max.compare_exchange_weak (
+               current, value, std::memory_order_relaxed)) {}
+}
+
+} // namespace
+
+namespace tracing {
+
+MemoryAccount::MemoryAccount (const char* name)
+    : _name (name), _counter_name (std::string ("Memory: ") + name),
+      _counter (_counter_name.c_str (), false),
+      _next (first_account.load ()) {
+    while (!first_account.compare_exchange_weak (_next, this)) {}
+}
+
+void MemoryAccount::updatePeaks (std::int64_t bytes) {
+    update_max (_peak, bytes);
+    update_max (_mission_peak, bytes);
+}
+
+void MemoryAccount::add (size_t bytes, int objects) {
+    _count.fetch_add (objects, std::memory_order_relaxed);
+    updatePeaks (
+        _bytes.fetch_add (std::int64_t (bytes), std::memory_order_relaxed) +
+        std::int64_t (bytes));
+}
+
+void MemoryAccount::remove (size_t bytes, int objects) {
+    _count.fetch_sub (objects, std::memory_order_relaxed);
+    _bytes.fetch_sub (std::int64_t (bytes), std::memory_order_relaxed);
+}
+
+void MemoryAccount::set (size_t bytes, int objects) {
+    _count.store (objects, std::memory_order_relaxed);
+    _bytes.store (std::int64_t (bytes), std::memory_order_relaxed);
+
+    updatePeaks (std::int64_t (bytes));
+}
+
+void MemoryAccount::resetMissionPeak () {
+    _mission_peak.store (_bytes.load (), std::memory_order_relaxed);
+}
+
+const MemoryAccount* MemoryAccount::first () { return first_account.load (); }
+
+void memory_process_frame () {
+    std::int64_t total = 0;
+
+    for (auto p = MemoryAccount::first (); p; p = p->next ()) {
+        counter::value (p->getCounter (), float (p->bytes ()));
+        total += p->bytes ();
+    }
+
+    counter::value (TotalMemory, float (total));
+}
+
+void memory_start_mission () {
+    for (auto p = first_account.load (); p; p = p->_next) {
+        p->resetMissionPeak ();
+    }
+}
+
+std::string get_memory_report () {
+    std::vector< const MemoryAccount* > accounts;
+
+    for (auto p = MemoryAccount::first (); p; p = p->next ()) {
+        accounts.push_back (p);
+    }
+
+    std::sort (
+        accounts.begin (), accounts.end (),
+        [](const MemoryAccount* lhs, const MemoryAccount* rhs) {
+            return lhs->bytes () > rhs->bytes ();
+        });
+
+    std::string out;
+    char buf[256];
+
+    snprintf (
+        buf, sizeof buf, "%-20s %10s %10s %10s %10s\n", "(MB)", "current",
+        "peak", "mission", "objects");
+    out += buf;
+
+    std::int64_t total = 0;
+
+    for (auto p : accounts) {
+        snprintf (
+            buf, sizeof buf, "%-20.20s %10.3f %10.3f %10.3f %10" PRId64 "\n",
+            p->getName (), to_mb (p->bytes ()), to_mb (p->peak ()),
+            to_mb (p->missionPeak ()), p->count ());
+        out += buf;
+
+        total += p->bytes ();
+    }
+
+    snprintf (buf, sizeof buf, "%-20s %10.3f\n", "total", to_mb (total));
+    out += buf;
+
+    return out;
+}
+
+DCF (memory, "Shows the memory held by the subsystems") {
+    if (dc_optional_string_either ("help", "--help")) {
+        dc_printf ("Usage: memory [reset]\n");
+        dc_printf ("No parameter shows the current, peak and mission peak\n");
+        dc_printf ("bytes of every subsystem, reset restarts the mission\n");
+        dc_printf ("peaks.\n");
+        return;
+    }
+
+    if (dc_optional_string ("reset")) {
+        memory_start_mission ();
+        return;
+    }
+
+    dc_printf ("%s", get_memory_report ().c_str ());
+}
+
+} // namespace tracing
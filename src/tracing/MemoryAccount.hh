@@ -0,0 +1,113 @@
+// -*- mode: c++; -*-
+
+#ifndef FREESPACE2_TRACING_MEMORYACCOUNT_HH
+#define FREESPACE2_TRACING_MEMORYACCOUNT_HH
+
+#include "defs.hh"
+
+#include "tracing/categories.hh"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+/** @file
+ *  @ingroup tracing
+ *
+ *  A registry of the memory held by the subsystems. Every subsystem keeps a
+ * static MemoryAccount and reports its allocations to it as they happen; the
+ * registry reports the current, peak and per-mission peak bytes of all the
+ * accounts, on the debug console, as counter events and in the log at the
+ * end of every mission.
+ */
+
+namespace tracing {
+
+/**
+ * @brief The bytes and the number of objects held by one subsystem
+ *
+ * Accounts register themselves on construction and are meant to be static
+ * objects that live as long as the program. The operations are atomic, they
+ * may be used from any thread.
+ */
+class MemoryAccount {
+    const char* _name;
+
+    std::string _counter_name;
+    Category _counter;
+
+    std::atomic< std::int64_t > _bytes{ 0 };
+    std::atomic< std::int64_t > _count{ 0 };
+
+    std::atomic< std::int64_t > _peak{ 0 };
+    std::atomic< std::int64_t > _mission_peak{ 0 };
+
+    MemoryAccount* _next;
+
+    void updatePeaks (std::int64_t bytes);
+
+    friend void memory_start_mission ();
+
+public:
+    explicit MemoryAccount (const char* name);
+
+    MemoryAccount (const MemoryAccount&) = delete;
+    MemoryAccount& operator= (const MemoryAccount&) = delete;
+
+    /**
+     * @brief Reports objects allocated, of bytes in total
+     */
+    void add (size_t bytes, int objects = 1);
+
+    /**
+     * @brief Reports objects freed, of bytes in total
+     */
+    void remove (size_t bytes, int objects = 1);
+
+    /**
+     * @brief Reports the whole of the memory held, for subsystems that keep
+     * their objects in an array that is resized rather than allocated one by
+     * one
+     */
+    void set (size_t bytes, int objects);
+
+    const char* getName () const { return _name; }
+    const Category& getCounter () const { return _counter; }
+
+    std::int64_t bytes () const { return _bytes.load (); }
+    std::int64_t count () const { return _count.load (); }
+    std::int64_t peak () const { return _peak.load (); }
+    std::int64_t missionPeak () const { return _mission_peak.load (); }
+
+    const MemoryAccount* next () const { return _next; }
+
+    /**
+     * @brief Restarts the mission peak from the current bytes
+     */
+    void resetMissionPeak ();
+
+    /**
+     * @brief The first of the registered accounts, in no particular order
+     */
+    static const MemoryAccount* first ();
+};
+
+/**
+ * @brief Submits the bytes of every account as counter events
+ */
+void memory_process_frame ();
+
+/**
+ * @brief Restarts the mission peaks of all the accounts
+ */
+void memory_start_mission ();
+
+/**
+ * @brief Formats the current, peak and mission peak bytes and the object
+ * counts of all the accounts, the largest first
+ */
+std::string get_memory_report ();
+
+} // namespace tracing
+
+#endif // FREESPACE2_TRACING_MEMORYACCOUNT_HH
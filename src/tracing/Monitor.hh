@@ -5,9 +5,11 @@
 
 #include "defs.hh"
 
+#include <atomic>
 #include <type_traits>
 
 #include "tracing/categories.hh"
+#include "tracing/tracing.hh"
 
 namespace tracing {
 
@@ -29,9 +31,11 @@ public:
     MonitorBase& operator= (MonitorBase&&) = delete;
 };
 
+// The value is atomic so that monitored code (e.g., model_collide) can be
+// called from several threads.
 template< typename T >
 class Monitor : public MonitorBase {
-    T _value;
+    std::atomic< T > _value;
 
     static_assert (
         std::is_convertible< T, float >::value,
@@ -43,7 +47,7 @@ public:
 
     void changeValue (const T& val) {
         _value = val;
-        valueChanged (_value);
+        valueChanged ((float)val);
     }
 
     Monitor< T >& operator= (const T& val) {
@@ -52,15 +56,13 @@ public:
     }
 
     Monitor< T >& operator+= (const T& val) {
-        _value += val;
-        valueChanged ((float)_value);
+        valueChanged ((float)(_value += val));
 
         return *this;
     }
 
     Monitor< T >& operator-= (const T& val) {
-        _value -= val;
-        valueChanged ((float)_value);
+        valueChanged ((float)(_value -= val));
 
         return *this;
     }
@@ -68,6 +70,8 @@ public:
 
 } // namespace tracing
 
+#if FS2_TRACING_LEVEL >= 2
+
 // Creates a monitor variable
 #define MONITOR(function_name) \
     static ::tracing::Monitor< int > mon_##function_name (#function_name, 0);
@@ -76,4 +80,14 @@ public:
 #define MONITOR_INC(function_name, inc) \
     do { mon_##function_name += (inc); } while (0)
 
+#else
+
+// The monitors count events in the inner loops, they are compiled in with
+// the detail scopes only
+#define MONITOR(function_name)
+#define MONITOR_INC(function_name, inc) \
+    do { } while (0)
+
+#endif // FS2_TRACING_LEVEL >= 2
+
 #endif // FREESPACE2_TRACING_MONITOR_HH
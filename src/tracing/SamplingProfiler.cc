@@ -0,0 +1,277 @@
+// -*- mode: c++; -*-
+
+#include "defs.hh"
+
+#include "tracing/SamplingProfiler.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+#include <signal.h>
+#include <sys/time.h>
+
+#if HAVE_EXECINFO_H
+#include <execinfo.h>
+#endif // HAVE_EXECINFO_H
+
+#if HAVE_CXXABI_H
+#include <cxxabi.h>
+#endif // HAVE_CXXABI_H
+
+namespace {
+
+using namespace tracing;
+
+// a power of two, enough for a few tens of milliseconds at any sane rate
+const size_t ring_size = 4096;
+
+// take_sample, the signal handler and the signal trampoline of the C library
+const int skipped_frames = 3;
+
+std::atomic< SamplingProfiler* > active_profiler{ nullptr };
+
+// The handlers running on any thread. A handler counts itself before it looks
+// for the profiler, so once the profiler is cleared and the count drops to
+// zero no handler can still be using it.
+std::atomic< int > running_handlers{ 0 };
+
+void sigprof_handler (int) {
+    const int saved_errno = errno;
+
+    running_handlers.fetch_add (1);
+
+    auto profiler = active_profiler.load ();
+    if (profiler) { profiler->take_sample (); }
+
+    running_handlers.fetch_sub (1);
+
+    errno = saved_errno;
+}
+
+// Turns a line of backtrace_symbols, "binary(mangled+0x1f) [0x4005d0]", into
+// the demangled function name, or the address when there is no name
+std::string symbol_name (void* address, const char* symbol) {
+    std::string name;
+
+    const char* begin = symbol ? strchr (symbol, '(') : nullptr;
+    const char* end = begin ? strpbrk (begin, "+)") : nullptr;
+
+    if (begin && end && end > begin + 1) {
+        name.assign (begin + 1, end);
+
+#if HAVE_CXXABI_H
+        int status = 0;
+        char* demangled =
+            abi::__cxa_demangle (name.c_str (), nullptr, nullptr, &status);
+
+        if (status == 0 && demangled) { name = demangled; }
+        free (demangled);
+#endif // HAVE_CXXABI_H
+    }
+    else {
+        char buf[32];
+        snprintf (buf, sizeof buf, "%p", address);
+        name = buf;
+    }
+
+    // the folded format separates the frames with semicolons and the count
+    // with a space
+    for (auto& c : name) {
+        if (c == ';' || c == ' ') { c = '_'; }
+    }
+
+    return name;
+}
+
+} // namespace
+
+namespace tracing {
+
+SamplingProfiler::SamplingProfiler (const char* filename, int rate)
+    : _filename (filename), _samples (new sample[ring_size]) {
+    for (size_t i = 0; i < ring_size; ++i) {
+        _samples[i].sequence.store (i, std::memory_order_relaxed);
+    }
+
+#if HAVE_EXECINFO_H
+    // The first call of backtrace loads libgcc, which is not safe to do in a
+    // signal handler
+    void* frames[1];
+    backtrace (frames, 1);
+
+    SamplingProfiler* expected = nullptr;
+
+    if (!active_profiler.compare_exchange_strong (expected, this)) {
+        WARNINGF (LOCATION, "Only one sampling profiler can run at a time");
+        return;
+    }
+
+    _thread = std::thread (&SamplingProfiler::run, this);
+
+    struct sigaction action;
+    memset (&action, 0, sizeof action);
+
+    action.sa_handler = sigprof_handler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset (&action.sa_mask);
+
+    sigaction (SIGPROF, &action, nullptr);
+
+    rate = (std::max) (1, (std::min) (rate, 100000));
+
+    // tv_usec must stay below a second
+    const long interval = 1000000L / rate;
+
+    struct itimerval timer;
+    timer.it_interval.tv_sec = interval / 1000000L;
+    timer.it_interval.tv_usec = interval % 1000000L;
+    timer.it_value = timer.it_interval;
+
+    if (setitimer (ITIMER_PROF, &timer, nullptr)) {
+        WARNINGF (
+            LOCATION, "Cannot start the profiling timer: %s",
+            strerror (errno));
+    }
+#else
+    (void)rate;
+    WARNINGF (LOCATION, "The sampling profiler needs execinfo.h");
+#endif // HAVE_EXECINFO_H
+}
+
+SamplingProfiler::~SamplingProfiler () {
+    if (active_profiler.load () != this) { return; }
+
+    struct itimerval timer;
+    memset (&timer, 0, sizeof timer);
+
+    setitimer (ITIMER_PROF, &timer, nullptr);
+    signal (SIGPROF, SIG_IGN);
+
+    active_profiler.store (nullptr);
+
+    // A signal delivered before the timer stopped may still be handled on
+    // another thread
+    while (running_handlers.load ()) { std::this_thread::yield (); }
+
+    _quit.store (true, std::memory_order_release);
+    _thread.join ();
+
+    write ();
+}
+
+// Not inlined into the signal handler, for the count of frames to skip
+__attribute__ ((noinline)) void SamplingProfiler::take_sample () {
+#if HAVE_EXECINFO_H
+    // A bounded multi-producer queue: a slot is free for the writer at pos
+    // when its sequence is pos and holds a sample when it is pos + 1
+    auto pos = _write_pos.load (std::memory_order_relaxed);
+    sample* slot;
+
+    for (;;) {
+        slot = &_samples[pos & (ring_size - 1)];
+
+        const auto sequence = slot->sequence.load (std::memory_order_acquire);
+        const auto diff = std::intptr_t (sequence) - std::intptr_t (pos);
+
+        if (diff == 0) {
+            if (_write_pos.compare_exchange_weak (
+                    pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            // The ring is full
+            _dropped.fetch_add (1, std::memory_order_relaxed);
+            return;
+        }
+        else {
+            pos = _write_pos.load (std::memory_order_relaxed);
+        }
+    }
+
+    void* frames[max_depth + skipped_frames];
+    const int depth = backtrace (frames, int (max_depth + skipped_frames));
+
+    slot->depth = (std::max) (0, depth - skipped_frames);
+    memcpy (
+        slot->frames, frames + skipped_frames, slot->depth * sizeof (void*));
+
+    slot->sequence.store (pos + 1, std::memory_order_release);
+#endif // HAVE_EXECINFO_H
+}
+
+void SamplingProfiler::drain () {
+    for (;;) {
+        auto& slot = _samples[_read_pos & (ring_size - 1)];
+
+        if (slot.sequence.load (std::memory_order_acquire) != _read_pos + 1) {
+            break;
+        }
+
+        std::vector< void* > stack (slot.frames, slot.frames + slot.depth);
+
+        slot.sequence.store (_read_pos + ring_size, std::memory_order_release);
+        ++_read_pos;
+
+        ++_stacks[std::move (stack)];
+        ++_count;
+    }
+}
+
+void SamplingProfiler::run () {
+    while (!_quit.load (std::memory_order_acquire)) {
+        drain ();
+        std::this_thread::sleep_for (std::chrono::milliseconds (10));
+    }
+
+    drain ();
+}
+
+void SamplingProfiler::write () {
+    std::ofstream out (_filename);
+
+    if (!out) {
+        WARNINGF (LOCATION, "Cannot open %s", _filename.c_str ());
+        return;
+    }
+
+#if HAVE_EXECINFO_H
+    std::unordered_map< void*, std::string > names;
+
+    for (const auto& item : _stacks) {
+        for (auto address : item.first) {
+            if (names.count (address)) { continue; }
+
+            char** symbols = backtrace_symbols (&address, 1);
+            names[address] = symbol_name (address, symbols ? symbols[0] : 0);
+            free (symbols);
+        }
+    }
+
+    for (const auto& item : _stacks) {
+        const auto& stack = item.first;
+
+        if (stack.empty ()) { continue; }
+
+        for (auto iter = stack.rbegin (); iter != stack.rend (); ++iter) {
+            if (iter != stack.rbegin ()) { out << ';'; }
+            out << names[*iter];
+        }
+
+        out << ' ' << item.second << '\n';
+    }
+#endif // HAVE_EXECINFO_H
+
+    WARNINGF (
+        LOCATION, "Sampling profiler: %lu samples, %lu dropped",
+        (unsigned long)_count, (unsigned long)_dropped.load ());
+}
+
+} // namespace tracing
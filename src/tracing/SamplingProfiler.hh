@@ -0,0 +1,87 @@
+// -*- mode: c++; -*-
+
+#ifndef FREESPACE2_TRACING_SAMPLINGPROFILER_HH
+#define FREESPACE2_TRACING_SAMPLINGPROFILER_HH
+
+#include "defs.hh"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/** @file
+ *  @ingroup tracing
+ */
+
+namespace tracing {
+
+/**
+ * @brief A statistical profiler sampling the call stacks of the running
+ * threads
+ *
+ * A SIGPROF interval timer interrupts the process at the given rate of CPU
+ * time; the signal handler takes the call stack of the interrupted thread and
+ * stores it in a lock-free ring. A background thread drains the ring and
+ * counts the distinct stacks. When the profiler is destroyed the stacks are
+ * symbolized and written in the folded format of the flame graph tools, one
+ * line per stack, outermost frame first, followed by the number of samples.
+ *
+ * Only one profiler can exist at a time. Without execinfo.h the profiler
+ * does nothing.
+ */
+class SamplingProfiler {
+public:
+    static const size_t max_depth = 48;
+
+    struct sample {
+        std::atomic< size_t > sequence;
+
+        int depth;
+        void* frames[max_depth];
+    };
+
+private:
+    std::string _filename;
+
+    std::unique_ptr< sample[] > _samples;
+
+    std::atomic< size_t > _write_pos{ 0 };
+    size_t _read_pos = 0;
+
+    std::atomic< std::uint64_t > _dropped{ 0 };
+    std::atomic< bool > _quit{ false };
+
+    // the distinct stacks, innermost frame first, and their sample counts
+    std::map< std::vector< void* >, std::uint64_t > _stacks;
+    std::uint64_t _count = 0;
+
+    std::thread _thread;
+
+    void drain ();
+    void run ();
+    void write ();
+
+public:
+    /**
+     * @param filename The file receiving the folded stacks
+     * @param rate The number of samples per second of CPU time
+     */
+    SamplingProfiler (const char* filename, int rate);
+    ~SamplingProfiler ();
+
+    SamplingProfiler (const SamplingProfiler&) = delete;
+    SamplingProfiler& operator= (const SamplingProfiler&) = delete;
+
+    /**
+     * @brief Stores the stack of the interrupted thread, called from the
+     * signal handler only
+     */
+    void take_sample ();
+};
+
+} // namespace tracing
+
+#endif // FREESPACE2_TRACING_SAMPLINGPROFILER_HH
@@ -7,17 +7,95 @@
 
 #include "tracing/tracing.hh"
 
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
 #include <thread>
 
-#include <boost/thread/sync_bounded_queue.hpp>
-#include <boost/thread/concurrent_queues/queue_op_status.hpp>
-
 /** @file
  *  @ingroup tracing
  */
 
 namespace tracing {
 
+namespace detail {
+
+/**
+ * @brief The maximum number of threads that can submit events to one
+ * processor; events of any further threads are dropped
+ */
+const size_t max_event_threads = 64;
+
+/**
+ * @brief Gets the slot of the calling thread in the per-thread event buffers
+ *
+ * Every thread gets its own slot the first time it submits an event and keeps
+ * it for its lifetime. Slots are not reused.
+ */
+inline size_t event_thread_slot () {
+    static std::atomic< size_t > next_slot{ 0 };
+    thread_local size_t slot = next_slot.fetch_add (1);
+
+    return slot;
+}
+
+/**
+ * @brief A bounded single-producer, single-consumer ring of events
+ *
+ * The producer only writes the tail and the consumer only writes the head, so
+ * neither side ever waits for the other. A full ring rejects the event.
+ *
+ * @tparam N The capacity of the ring, a power of two
+ */
+template< size_t N >
+class event_ring {
+    static_assert ((N & (N - 1)) == 0, "the capacity must be a power of two");
+
+    alignas (64) std::atomic< size_t > _head{ 0 };
+    alignas (64) std::atomic< size_t > _tail{ 0 };
+
+    trace_event _events[N];
+
+public:
+    /**
+     * @brief Appends an event, called from the producer thread only
+     * @return false if the ring is full
+     */
+    bool push (const trace_event& event) {
+        const auto tail = _tail.load (std::memory_order_relaxed);
+
+        if (tail - _head.load (std::memory_order_acquire) == N) {
+            return false;
+        }
+
+        _events[tail & (N - 1)] = event;
+        _tail.store (tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /**
+     * @brief Passes every event in the ring to fun and frees their slots,
+     * called from the consumer thread only
+     * @return The number of events consumed
+     */
+    template< typename Function >
+    size_t drain (Function&& fun) {
+        auto head = _head.load (std::memory_order_relaxed);
+        const auto tail = _tail.load (std::memory_order_acquire);
+
+        for (auto pos = head; pos != tail; ++pos) {
+            fun (&_events[pos & (N - 1)]);
+        }
+
+        _head.store (tail, std::memory_order_release);
+
+        return tail - head;
+    }
+};
+
+} // namespace detail
+
 /**
  * @brief A multi-threaded event processor
  *
@@ -32,56 +110,113 @@ namespace tracing {
  * This function will be called in a background-thread whenever a new event
  * arrives.
  *
+ * Every submitting thread has its own lock-free ring buffer, which the
+ * background thread drains in batches. Submitting an event never blocks: when
+ * the background thread falls behind and the ring of a thread is full the
+ * event is dropped and counted instead. Events of one thread reach the
+ * processor in the order they were submitted; events of different threads
+ * may be interleaved in any order.
+ *
  * @tparam Processor Your processor implementation
- * @tparam N The maximum size of the internal event buffer
+ * @tparam N The number of events buffered for each thread, a power of two
  */
-template< class Processor, size_t N = 200 >
+template< class Processor, size_t N = 4096 >
 struct ThreadedEventProcessor {
     template< typename... Params >
     explicit ThreadedEventProcessor (Params&&... params)
-        : q_ (N),
-          w_ (&ThreadedEventProcessor< Processor >::workerThread, this),
-          p_ (std::forward< Params > (params)...) {}
+        : p_ (std::forward< Params > (params)...),
+          w_ (&ThreadedEventProcessor::workerThread, this) {}
 
     ~ThreadedEventProcessor () {
-        q_.close ();
+        quit_.store (true, std::memory_order_release);
         w_.join ();
+
+        for (auto& ring : rings_) {
+            delete ring.load (std::memory_order_relaxed);
+        }
+
+        if (dropped ()) {
+            WARNINGF (
+                LOCATION, "Tracing dropped %" PRIu64 " events",
+                dropped ());
+        }
     }
 
     void processEvent (const trace_event* event) {
-        using namespace boost::concurrent;
+        const auto slot = detail::event_thread_slot ();
 
-        try {
-            q_.wait_push_back (*event);
+        if (slot >= detail::max_event_threads) {
+            dropped_.fetch_add (1, std::memory_order_relaxed);
+            return;
         }
-        catch (const sync_queue_is_closed&) {
-            WARNINGF (LOCATION,"Stream queue was closed in processEvent! This should not be possible...");
+
+        // Only the owning thread ever creates the ring of a slot
+        auto ring = rings_[slot].load (std::memory_order_acquire);
+
+        if (!ring) {
+            ring = new ring_type;
+            rings_[slot].store (ring, std::memory_order_release);
         }
+
+        if (!ring->push (*event)) {
+            dropped_.fetch_add (1, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief The number of events that were dropped because a buffer was full
+     */
+    std::uint64_t dropped () const {
+        return dropped_.load (std::memory_order_relaxed);
     }
 
+    /**
+     * @brief The wrapped processor, only for its members that are safe to
+     * call while the background thread runs
+     */
+    Processor& processor () { return p_; }
+
 private:
-    void workerThread () {
-        using namespace boost;
-        using boost::concurrent::sync_queue_is_closed;
+    typedef detail::event_ring< N > ring_type;
 
-        while (!q_.closed ()) {
-            try {
-                trace_event evt;
+    size_t drainAll () {
+        size_t count = 0;
 
-                if (queue_op_status::success != q_.wait_pull_front (evt))
-                    break;
+        for (auto& slot : rings_) {
+            auto ring = slot.load (std::memory_order_acquire);
 
-                p_.processEvent (&evt);
+            if (ring) {
+                count += ring->drain (
+                    [this](const trace_event* evt) { p_.processEvent (evt); });
             }
-            catch (const sync_queue_is_closed&) {
-                break;
+        }
+
+        return count;
+    }
+
+    void workerThread () {
+        for (;;) {
+            // Everything submitted before the quit flag was raised is drained
+            // by the pass following the load
+            const auto quit = quit_.load (std::memory_order_acquire);
+
+            const auto count = drainAll ();
+
+            if (quit) { break; }
+
+            if (count == 0) {
+                std::this_thread::sleep_for (std::chrono::milliseconds (1));
             }
         }
     }
 
-    boost::sync_bounded_queue< trace_event > q_;
-    std::thread w_;
+    std::atomic< ring_type* > rings_[detail::max_event_threads] = {};
+    std::atomic< std::uint64_t > dropped_{ 0 };
+    std::atomic< bool > quit_{ false };
+
+    // The processor is constructed before the thread that uses it starts
     Processor p_;
+    std::thread w_;
 };
 
 } // namespace tracing
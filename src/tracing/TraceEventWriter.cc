@@ -1,116 +1,100 @@
 // -*- mode: c++; -*-
 
-#include <iomanip>
+#include <algorithm>
+#include <cstring>
 
 #include "defs.hh"
 #include "tracing/TraceEventWriter.hh"
+#include "tracing/TraceFormat.hh"
 #include "assert/assert.hh"
 
 namespace {
-using namespace tracing;
-
-const char* getTypeStr (tracing::EventType type) {
-    switch (type) {
-    case tracing::EventType::Complete: return "X";
-    case tracing::EventType::Begin: return "B";
-    case tracing::EventType::End: return "E";
-    case EventType::AsyncBegin: return "b";
-    case EventType::AsyncStep: return "n";
-    case EventType::AsyncEnd: return "e";
-    case EventType::Counter: return "C";
-    default:
-        ASSERT (0);
-        return "";
-    }
-}
 
-void writeTime (std::ofstream& out, std::uint64_t time) {
-    // Save stream state
-    auto flags = out.flags ();
-    out << std::fixed << std::setprecision (3);
+// The records are collected here and written in blocks of this size
+const size_t buffer_size = 1 << 20;
 
-    out << (time / 1000.);
+} // namespace
 
-    // and now restore it
-    out.flags (flags);
-}
+namespace tracing {
 
-void writeCompleteEvent (std::ofstream& out_str, const trace_event* evt) {
-    ASSERTX (
-        evt->type == EventType::Complete, "Event must be a complete event!");
+TraceEventWriter::TraceEventWriter (const char* filename)
+    : _out (filename, std::ios::binary | std::ios::trunc) {
+    if (!_out) { WARNINGF (LOCATION, "Cannot open trace file %s", filename); }
 
-    out_str << ",\"dur\":";
-    writeTime (out_str, evt->duration);
-}
-} // namespace
+    _buffer.reserve (buffer_size);
 
-namespace tracing {
+    format::file_header header{};
+
+    memcpy (header.magic, format::magic, sizeof header.magic);
+    header.version = format::version;
 
-TraceEventWriter::TraceEventWriter () : _out ("tracing/trace.json") {
-    _out << "[";
+    write (&header, sizeof header);
 }
 
 TraceEventWriter::~TraceEventWriter () {
-    _out << "]\n";
+    flush ();
     _out.close ();
 }
 
-void TraceEventWriter::processEvent (const trace_event* event) {
-    if (event->type == EventType::Complete) {
-        if (event->duration < 1000) {
-            // Discard events that are less than a millisecond long
-            return;
-        }
-    }
+void TraceEventWriter::write (const void* data, size_t size) {
+    if (_buffer.size () + size > buffer_size) { flush (); }
 
-    if (!_first_line) { _out << ","; }
-    _out << "\n{\"tid\": " << event->tid << ",\"ts\":";
+    const auto p = static_cast< const char* > (data);
+    _buffer.insert (_buffer.end (), p, p + size);
+}
 
-    writeTime (_out, event->timestamp);
+void TraceEventWriter::flush () {
+    _out.write (_buffer.data (), _buffer.size ());
+    _buffer.clear ();
+}
 
-    _out << ",\"pid\":";
-    if (event->pid == GPU_PID) { _out << "\"GPU\""; }
-    else {
-        _out << event->pid;
-    }
+std::uint32_t TraceEventWriter::intern (
+    const void* key, const char* name, std::uint8_t kind) {
+    auto iter = _names.find (key);
 
-    if (event->scope != nullptr) {
-        _out << ",\"cat\":\"" << event->scope->getName () << "\"";
-        _out << ",\"id\":\"" << reinterpret_cast< const void* > (event->scope)
-             << "\"";
-    }
+    if (iter != _names.end ()) { return iter->second; }
 
-    _out << ",\"name\":\"" << event->category->getName () << "\",\"ph\":\""
-         << getTypeStr (event->type) << "\"";
-
-    switch (event->type) {
-    case EventType::Complete: writeCompleteEvent (_out, event); break;
-    case EventType::Begin:
-    case EventType::End:
-        // Nothing to do here
-        break;
-    case EventType::AsyncBegin:
-    case EventType::AsyncStep:
-    case EventType::AsyncEnd:
-        // Nothing to do here...
-        break;
-    case EventType::Counter: {
-        auto flags = _out.flags ();
-        _out << std::fixed;
-
-        _out << ",\"args\": {\"value\": " << event->value << "}";
-
-        // and now restore it
-        _out.flags (flags);
-        break;
-    }
-    default:
-        ASSERT (0);
-        break;
+    const auto id = _next_name++;
+    _names.emplace (key, id);
+
+    const size_t length = (std::min) (strlen (name), size_t (UINT16_MAX));
+
+    format::name_header header{};
+
+    header.tag = format::name_record;
+    header.kind = kind;
+    header.length = std::uint16_t (length);
+    header.id = id;
+
+    write (&header, sizeof header);
+    write (name, length);
+
+    return id;
+}
+
+void TraceEventWriter::processEvent (const trace_event* event) {
+    ASSERT (event->type != EventType::Invalid);
+
+    format::event record{};
+
+    record.tag = format::event_record;
+    record.type = std::uint8_t (event->type);
+
+    record.category = intern (
+        event->category, event->category->getName (), format::category_name);
+
+    if (event->scope) {
+        record.scope = intern (
+            event->scope, event->scope->getName (), format::scope_name);
     }
 
-    _out << "}";
+    record.timestamp = event->timestamp;
+    record.duration = event->duration;
+    record.event_id = event->event_id;
+    record.tid = event->tid;
+    record.pid = event->pid;
+    record.value = event->value;
 
-    _first_line = false;
+    write (&record, sizeof record);
 }
 } // namespace tracing
@@ -9,24 +9,48 @@
 #include "tracing/ThreadedEventProcessor.hh"
 
 #include <fstream>
+#include <unordered_map>
+#include <vector>
 
 /** @file
  *  @ingroup tracing
  */
 
 namespace tracing {
+
+/**
+ * @brief Writes every event to a binary trace file
+ *
+ * The records are described in TraceFormat.hh; the traceconvert tool turns a
+ * file into Chrome trace JSON. Category and scope names are written once and
+ * referred to by id afterwards.
+ */
 class TraceEventWriter {
     std::ofstream _out;
-    bool _first_line = true;
+
+    std::vector< char > _buffer;
+
+    // name ids of the categories and scopes written so far
+    std::unordered_map< const void*, std::uint32_t > _names;
+    std::uint32_t _next_name = 1;
+
+    void write (const void* data, size_t size);
+    void flush ();
+
+    std::uint32_t
+    intern (const void* key, const char* name, std::uint8_t kind);
 
 public:
-    TraceEventWriter ();
+    explicit TraceEventWriter (const char* filename);
     ~TraceEventWriter ();
 
     void processEvent (const trace_event* event);
 };
 
-typedef ThreadedEventProcessor< TraceEventWriter > ThreadedTraceEventWriter;
+// A full capture submits many short events per frame, the buffers are sized
+// to ride out a slow disk write
+typedef ThreadedEventProcessor< TraceEventWriter, 1 << 16 >
+    ThreadedTraceEventWriter;
 } // namespace tracing
 
 #endif // FREESPACE2_TRACING_TRACEEVENTWRITER_HH
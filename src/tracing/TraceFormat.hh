@@ -0,0 +1,79 @@
+// -*- mode: c++; -*-
+
+#ifndef FREESPACE2_TRACING_TRACEFORMAT_HH
+#define FREESPACE2_TRACING_TRACEFORMAT_HH
+
+#include "defs.hh"
+
+#include <cstdint>
+
+/** @file
+ *  @ingroup tracing
+ *
+ *  The layout of the binary trace files written by TraceEventWriter and read
+ * by the traceconvert tool.
+ *
+ *  A file starts with a file_header, followed by a stream of records in the
+ * byte order of the machine that wrote it. Every record starts with its tag.
+ * A name record is a name_header followed by the bytes of the name, without a
+ * terminator; it is written once, before the first event that refers to the
+ * name. An event record is a fixed-size event.
+ */
+
+namespace tracing {
+namespace format {
+
+const char magic[8] = { 'F', 'S', '2', 'T', 'R', 'A', 'C', 'E' };
+const std::uint32_t version = 1;
+
+/**
+ * @brief The first byte of every record
+ */
+enum record_tag : std::uint8_t { name_record = 1, event_record = 2 };
+
+/**
+ * @brief What a name record names
+ */
+enum name_kind : std::uint8_t { category_name = 0, scope_name = 1 };
+
+struct file_header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t reserved;
+};
+
+struct name_header {
+    std::uint8_t tag; // name_record
+    std::uint8_t kind;
+    std::uint16_t length;
+    std::uint32_t id;
+};
+
+struct event {
+    std::uint8_t tag;  // event_record
+    std::uint8_t type; // tracing::EventType
+    std::uint16_t reserved0;
+
+    std::uint32_t category; // name id
+    std::uint32_t scope;    // name id, 0 if the event has no scope
+    std::uint32_t reserved1;
+
+    std::uint64_t timestamp; // nanoseconds
+    std::uint64_t duration;  // nanoseconds
+    std::uint64_t event_id;
+
+    std::int64_t tid;
+    std::int64_t pid;
+
+    float value;
+    std::uint32_t reserved2;
+};
+
+static_assert (sizeof (file_header) == 16, "unexpected file header padding");
+static_assert (sizeof (name_header) == 8, "unexpected name header padding");
+static_assert (sizeof (event) == 64, "unexpected event record padding");
+
+} // namespace format
+} // namespace tracing
+
+#endif // FREESPACE2_TRACING_TRACEFORMAT_HH
@@ -4,8 +4,14 @@
 
 namespace tracing {
 
+static int next_category_index () {
+    static int next_index = 1;
+    return next_index < MAX_CATEGORIES ? next_index++ : 0;
+}
+
 Category::Category (const char* name, bool is_graphics)
-    : _name (name), _graphics_category (is_graphics) {}
+    : _name (name), _graphics_category (is_graphics),
+      _index (next_category_index ()) {}
 const char* Category::getName () const { return _name; }
 bool Category::usesGPUCounter () const { return _graphics_category; }
 
@@ -32,6 +38,9 @@ Category LoadBatchingBuffers ("Load batching buffers", true);
 Category SortColliders ("Sort Colliders", false);
 Category FindOverlapColliders ("Find overlap colliders", false);
 Category CollidePair ("Collide Pair", false);
+Category CollisionTests ("Collision tests", false);
+Category CollisionResponse ("Collision response", false);
+Category ObjectGrid ("Object grid", false);
 
 Category WeaponPostMove ("Weapon post move", false);
 Category ShipPostMove ("Ship post move", false);
@@ -40,6 +49,7 @@ Category DebrisPostMove ("Debris post move", false);
 Category AsteroidPostMove ("Asteroid post move", false);
 Category PreMove ("Pre Move", false);
 Category Physics ("Physics", false);
+Category ParallelPhysics ("Parallel physics", false);
 Category PostMove ("Post Move", false);
 Category CollisionDetection ("Collision Detection", false);
 
@@ -131,4 +141,8 @@ Category RenderDecals ("Render all decals", true);
 Category RenderSingleDecal ("Render single decal", true);
 Category GpuHeapAllocate ("GPU heap allocate", false);
 Category GpuHeapDeallocate ("GPU heap deallocate", false);
+
+Category Allocations ("Allocations", false);
+Category AllocatedBytes ("Allocated bytes", false);
+Category Frees ("Frees", false);
 } // namespace tracing
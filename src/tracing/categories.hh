@@ -16,9 +16,15 @@
 
 namespace tracing {
 
+/**
+ * @brief The most categories that can exist, including those of the monitors
+ */
+const int MAX_CATEGORIES = 512;
+
 class Category {
     const char* _name;
     bool _graphics_category;
+    int _index;
 
 public:
     Category (const char* name, bool is_graphics);
@@ -26,6 +32,12 @@ public:
     const char* getName () const;
 
     bool usesGPUCounter () const;
+
+    /**
+     * @brief A number unique to this category, below MAX_CATEGORIES, or 0
+     * when more categories were created than that
+     */
+    int getIndex () const { return _index; }
 };
 
 extern Category LuaOnFrame;
@@ -50,7 +62,10 @@ extern Category LoadBatchingBuffers;
 
 extern Category SortColliders;
 extern Category FindOverlapColliders;
-extern Category CollidePair;
+extern Category CollidePair;
+extern Category CollisionTests;
+extern Category CollisionResponse;
+extern Category ObjectGrid;
 
 extern Category WeaponPostMove;
 extern Category ShipPostMove;
@@ -59,6 +74,7 @@ extern Category DebrisPostMove;
 extern Category AsteroidPostMove;
 extern Category PreMove;
 extern Category Physics;
+extern Category ParallelPhysics;
 extern Category PostMove;
 extern Category CollisionDetection;
 
@@ -151,6 +167,10 @@ extern Category RenderSingleDecal;
 extern Category GpuHeapAllocate;
 extern Category GpuHeapDeallocate;
 
+extern Category Allocations;
+extern Category AllocatedBytes;
+extern Category Frees;
+
 } // namespace tracing
 
 #endif // FREESPACE2_TRACING_CATEGORIES_HH
@@ -1,26 +1,39 @@
 // -*- mode: c++; -*-
 
+#include <algorithm>
+#include <atomic>
 #include <cinttypes>
 #include <fstream>
 #include <future>
 #include <mutex>
 #include <queue>
+#include <unordered_map>
 
 #include "defs.hh"
 #include "tracing/tracing.hh"
+#include "debugconsole/console.hh"
 #include "graphics/2d.hh"
 #include "parse/parselo.hh"
 #include "io/timer.hh"
 #include "TraceEventWriter.hh"
 #include "MainFrameTimer.hh"
 #include "FrameProfiler.hh"
+#include "AllocationTracker.hh"
+#include "FrameStatistics.hh"
+#include "FlightRecorder.hh"
+#include "SamplingProfiler.hh"
 #include "assert/assert.hh"
 
 // A function for getting the id of the current thread
 #if __LINUX__
 #include <sys/syscall.h>
 
-static int64_t get_tid () { return (int64_t)syscall (SYS_gettid); }
+static int64_t get_tid () {
+    // The id is looked up once per thread, events are submitted too often to
+    // make a system call for each
+    thread_local int64_t tid = (int64_t)syscall (SYS_gettid);
+    return tid;
+}
 #else
 #include <pthread.h>
 
@@ -36,6 +49,13 @@ static int64_t get_tid () {
 
 static int64_t get_pid () { return (int64_t)getpid (); }
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+
+#define FS2_TRACING_TSC 1
+#endif
+
 namespace {
 
 using namespace tracing;
@@ -43,6 +63,9 @@ using namespace tracing;
 std::unique_ptr< ThreadedTraceEventWriter > traceEventWriter;
 std::unique_ptr< ThreadedMainFrameTimer > mainFrameTimer;
 std::unique_ptr< FrameProfiler > frameProfiler;
+std::unique_ptr< FrameStatistics > frameStatistics;
+std::unique_ptr< SamplingProfiler > samplingProfiler;
+std::unique_ptr< ThreadedFlightRecorder > flightRecorder;
 
 std::vector< int > query_objects;
 // The GPU timestamp queries use an internal free list to reduce the number of
@@ -93,7 +116,22 @@ int gpu_start_query = -1;
 std::uint64_t gpu_start_time = 0;
 std::uint64_t cpu_start_time = 0;
 
-std::uint64_t current_id = 0;
+// Events may be submitted from any thread
+std::atomic< std::uint64_t > current_id{ 0 };
+
+bool do_category_totals = false;
+std::mutex category_totals_mutex;
+std::unordered_map< const Category*, totals::category_total > category_totals;
+
+void add_to_totals (const trace_event* evt) {
+    std::lock_guard< std::mutex > guard (category_totals_mutex);
+
+    auto& total = category_totals[evt->category];
+
+    total.category = evt->category;
+    total.count++;
+    total.duration += evt->duration;
+}
 
 void submit_event (trace_event* evt) {
     if (evt->pid == GPU_PID) { evt->timestamp -= gpu_start_time; }
@@ -109,6 +147,15 @@ void submit_event (trace_event* evt) {
     if (mainFrameTimer) { mainFrameTimer->processEvent (evt); }
 
     if (frameProfiler) { frameProfiler->processEvent (evt); }
+
+    if (frameStatistics) { frameStatistics->processEvent (evt); }
+
+    if (flightRecorder) { flightRecorder->processEvent (evt); }
+
+    if (do_category_totals && evt->type == EventType::Complete &&
+        evt->pid != GPU_PID) {
+        add_to_totals (evt);
+    }
 }
 
 void process_gpu_events () {
@@ -188,10 +235,91 @@ void process_gpu_events () {
     }
 }
 
+// GPU queries can only be issued from the main thread, events of other threads
+// only get CPU timings
+bool use_gpu_queries (const Category& category, std::int64_t tid) {
+    return do_gpu_queries && category.usesGPUCounter () &&
+           tid == main_thread_id;
+}
+
+// The event timestamps come from the TSC when it ticks at a constant rate:
+// reading it is a single instruction where timer_get_nanoseconds goes through
+// SDL and a long double multiplication. The ticks are scaled to the timebase
+// of timer_get_nanoseconds, so both kinds of timestamps can be mixed.
+bool use_tsc = false;
+std::uint64_t tsc_base = 0;
+std::uint64_t tsc_base_time = 0;
+double tsc_tick_time = 0.;
+
+#if FS2_TRACING_TSC
+bool has_invariant_tsc () {
+    unsigned eax, ebx, ecx, edx;
+
+    if (!__get_cpuid (0x80000000, &eax, &ebx, &ecx, &edx) ||
+        eax < 0x80000007) {
+        return false;
+    }
+
+    __get_cpuid (0x80000007, &eax, &ebx, &ecx, &edx);
+    return edx & (1U << 8);
+}
+#endif // FS2_TRACING_TSC
+
+// Measures the TSC rate against the timer, called once before the first
+// event is traced
+void calibrate_timestamps () {
+#if FS2_TRACING_TSC
+    if (use_tsc || !has_invariant_tsc ()) { return; }
+
+    const auto time = timer_get_nanoseconds ();
+    const auto tsc = __rdtsc ();
+
+    // 10 ms keeps the error of the rate well below a part per million
+    std::uint64_t now;
+    while ((now = timer_get_nanoseconds ()) - time < 10000000) {}
+
+    const auto ticks = __rdtsc () - tsc;
+
+    if (ticks > 0) {
+        tsc_base = tsc;
+        tsc_base_time = time;
+        tsc_tick_time = double (now - time) / double (ticks);
+        use_tsc = true;
+    }
+#endif // FS2_TRACING_TSC
+}
+
+inline std::uint64_t get_timestamp () {
+#if FS2_TRACING_TSC
+    if (use_tsc) {
+        return tsc_base_time +
+               std::uint64_t (double (__rdtsc () - tsc_base) * tsc_tick_time);
+    }
+#endif // FS2_TRACING_TSC
+
+    return timer_get_nanoseconds ();
+}
+
+// The categories of the complete events open on this thread, innermost last;
+// the depth keeps counting past the end of the array
+const int max_scope_depth = 64;
+
+thread_local const Category* scope_stack[max_scope_depth];
+thread_local int scope_depth = 0;
+
+void push_scope (const Category* category) {
+    if (scope_depth < max_scope_depth) { scope_stack[scope_depth] = category; }
+    ++scope_depth;
+}
+
+void pop_scope () {
+    if (scope_depth > 0) { --scope_depth; }
+}
+
 void init_event (const Category& category, trace_event* evt) {
     evt->category = &category;
 
-    evt->timestamp = timer_get_nanoseconds ();
+    evt->timestamp = get_timestamp ();
 
     evt->pid = get_pid ();
     evt->tid = get_tid ();
@@ -199,6 +327,12 @@ void init_event (const Category& category, trace_event* evt) {
 } // namespace
 
 namespace tracing {
+const Category* current_category () {
+    if (scope_depth == 0) { return nullptr; }
+
+    return scope_stack[(std::min) (scope_depth, max_scope_depth) - 1];
+}
+
 void init () {
     do_trace_events = false;
     do_async_events = false;
@@ -209,11 +343,47 @@ void init () {
         do_async_events = true;
     }
 
+    if (Cmdline_profile_trace) {
+        traceEventWriter.reset (
+            new ThreadedTraceEventWriter (Cmdline_profile_trace));
+        do_trace_events = true;
+        do_async_events = true;
+        do_counter_events = true;
+    }
+
     if (Cmdline_frame_profile) {
         frameProfiler.reset (new FrameProfiler ());
         do_trace_events = true;
     }
 
+    if (Cmdline_frame_stats) {
+        frameStatistics.reset (new FrameStatistics (
+            std::uint64_t (Cmdline_frame_budget * 1e6)));
+        do_trace_events = true;
+        do_async_events = true;
+    }
+
+    if (Cmdline_profile_allocations) {
+        allocations::enable ();
+        do_trace_events = true;
+        do_counter_events = true;
+    }
+
+    if (Cmdline_flight_recorder) {
+        flightRecorder.reset (new ThreadedFlightRecorder (
+            Cmdline_flight_recorder,
+            std::uint64_t (Cmdline_flight_window * 1e9),
+            std::uint64_t (Cmdline_frame_budget * 1e6)));
+        do_trace_events = true;
+        do_async_events = true;
+        do_counter_events = true;
+    }
+
+    if (Cmdline_profile_samples) {
+        samplingProfiler.reset (new SamplingProfiler (
+            Cmdline_profile_samples, Cmdline_profile_sample_rate));
+    }
+
     do_gpu_queries = gr_is_capable (CAPABILITY_TIMESTAMP_QUERY);
 
     if (do_gpu_queries) { gpu_start_query = get_gpu_timestamp_query (); }
@@ -221,6 +391,10 @@ void init () {
 
     main_thread_id = get_tid ();
 
+    if (do_trace_events || do_async_events || do_counter_events) {
+        calibrate_timestamps ();
+    }
+
     initialized = true;
 }
 
@@ -244,6 +418,69 @@ std::string get_frame_profile_output () {
     return frameProfiler->getContent ();
 }
 
+std::string get_frame_statistics_summary () {
+    if (!frameStatistics) { return "frame statistics need -frame_stats\n"; }
+
+    return frameStatistics->getSummary ();
+}
+
+void reset_frame_statistics () {
+    if (frameStatistics) { frameStatistics->reset (); }
+}
+
+void set_frame_budget (float budget) {
+    if (frameStatistics) {
+        frameStatistics->setBudget (std::uint64_t (budget * 1e6));
+    }
+
+    if (flightRecorder) {
+        flightRecorder->processor ().setBudget (std::uint64_t (budget * 1e6));
+    }
+}
+
+void dump_flight_recorder () {
+    if (flightRecorder) { flightRecorder->processor ().requestDump (); }
+}
+
+DCF (frame_stats, "Shows the frame time percentiles (-frame_stats)") {
+    if (dc_optional_string_either ("help", "--help")) {
+        dc_printf ("Usage: frame_stats [reset | budget <ms>]\n");
+        dc_printf ("No parameter shows the percentiles gathered so far,\n");
+        dc_printf ("reset forgets them and budget sets the frame budget.\n");
+        return;
+    }
+
+    if (dc_optional_string ("reset")) {
+        reset_frame_statistics ();
+        return;
+    }
+
+    if (dc_optional_string ("budget")) {
+        float budget;
+        dc_stuff_float (&budget);
+        set_frame_budget (budget);
+        return;
+    }
+
+    dc_printf ("%s", get_frame_statistics_summary ().c_str ());
+}
+
+DCF (flight_dump, "Writes the recent trace events (-flight_recorder)") {
+    if (dc_optional_string_either ("help", "--help")) {
+        dc_printf ("Usage: flight_dump\n");
+        dc_printf ("Writes the trace events of the last seconds to the next\n");
+        dc_printf ("file of the -flight_recorder prefix.\n");
+        return;
+    }
+
+    if (!flightRecorder) {
+        dc_printf ("the flight recorder needs -flight_recorder\n");
+        return;
+    }
+
+    dump_flight_recorder ();
+}
+
 void shutdown () {
     while (!gpu_events.empty ()) {
         process_events ();
@@ -255,6 +492,9 @@ void shutdown () {
 
     mainFrameTimer = nullptr;
     traceEventWriter = nullptr;
+    frameStatistics = nullptr;
+    samplingProfiler = nullptr;
+    flightRecorder = nullptr;
 
     initialized = false;
 }
@@ -275,11 +515,9 @@ void start (const Category& category, trace_event* evt) {
     evt->type = EventType::Complete;
     evt->event_id = ++current_id;
 
-    if (do_gpu_queries && category.usesGPUCounter ()) {
-        ASSERTX (
-            get_tid () == main_thread_id,
-            "This function must be called from the main thread!");
+    push_scope (&category);
 
+    if (use_gpu_queries (category, evt->tid)) {
         gpu_trace_event gpu_event;
         gpu_event.base_evt.category = &category;
         gpu_event.base_evt.tid = 1;
@@ -295,11 +533,13 @@ void start (const Category& category, trace_event* evt) {
 }
 
 void end (trace_event* evt) {
-    if (!do_trace_events) {
-        // No one to process the event is here
+    if (evt->type != EventType::Complete) {
+        // The event was not started, no one was there to process it
         return;
     }
 
+    pop_scope ();
+
     if (!initialized) { return; }
 
     ASSERTX (
@@ -309,18 +549,14 @@ void end (trace_event* evt) {
         evt->tid == get_tid (),
         "Complete events must be generated from the same thread!");
 
-    evt->duration = timer_get_nanoseconds () - evt->timestamp;
+    evt->duration = get_timestamp () - evt->timestamp;
     evt->end_event_id = ++current_id;
 
     // Process CPU events
     submit_event (evt);
 
     // Create GPU events
-    if (do_gpu_queries && evt->category->usesGPUCounter ()) {
-        ASSERTX (
-            get_tid () == main_thread_id,
-            "This function must be called from the main thread!");
-
+    if (use_gpu_queries (*evt->category, evt->tid)) {
         gpu_trace_event gpu_event;
         gpu_event.base_evt.category = evt->category;
         gpu_event.base_evt.tid = 1;
@@ -380,6 +616,42 @@ void end (const Category& category, const Scope& async_scope) {
 
 } // namespace async
 
+namespace totals {
+
+void enable () {
+    calibrate_timestamps ();
+
+    do_category_totals = true;
+    do_trace_events = true;
+}
+
+void reset () {
+    std::lock_guard< std::mutex > guard (category_totals_mutex);
+    category_totals.clear ();
+}
+
+std::vector< category_total > get () {
+    std::vector< category_total > result;
+
+    {
+        std::lock_guard< std::mutex > guard (category_totals_mutex);
+
+        for (const auto& item : category_totals) {
+            result.push_back (item.second);
+        }
+    }
+
+    std::sort (
+        result.begin (), result.end (),
+        [](const category_total& lhs, const category_total& rhs) {
+            return lhs.duration > rhs.duration;
+        });
+
+    return result;
+}
+
+} // namespace totals
+
 namespace counter {
 
 void value (const Category& category, float value) {
@@ -81,6 +81,37 @@ void frame_profile_process_frame ();
  */
 std::string get_frame_profile_output ();
 
+/**
+ * @brief Gets the category of the innermost complete event open on the
+ * calling thread
+ * @return The category, or nullptr outside of any complete event
+ */
+const Category* current_category ();
+
+/**
+ * @brief Gets the frame time and category percentiles gathered since the last
+ * reset, when -frame_stats is enabled
+ */
+std::string get_frame_statistics_summary ();
+
+/**
+ * @brief Forgets the frame time statistics gathered so far
+ */
+void reset_frame_statistics ();
+
+/**
+ * @brief Sets the frame time above which frames count as over budget, and
+ * trigger a flight recorder dump
+ * @param budget The budget in milliseconds
+ */
+void set_frame_budget (float budget);
+
+/**
+ * @brief Writes the trace events of the last seconds to a file, when
+ * -flight_recorder is enabled
+ */
+void dump_flight_recorder ();
+
 /**
  * @brief Deinitializes the tracing subsystem
  */
@@ -89,6 +120,10 @@ void shutdown ();
 namespace complete {
 /**
  * @brief Starts a complete event
+ *
+ * @note Events can be submitted from multiple threads, GPU timings are only
+ * taken on the main thread
+ *
  * @param category The category this event belongs to
  * @param evt The event which hold the data
  */
@@ -149,6 +184,38 @@ void step (const Category& category, const Scope& async_scope);
 void end (const Category& category, const Scope& async_scope);
 } // namespace async
 
+namespace totals {
+
+/**
+ * @brief The accumulated complete events of one category
+ */
+struct category_total {
+    const Category* category = nullptr;
+
+    std::uint64_t count = 0;
+    std::uint64_t duration = 0; // nanoseconds, nested events included
+};
+
+/**
+ * @brief Starts adding up the complete events of every category
+ *
+ * @note Complete events are recorded from here on even if no other consumer
+ * asked for them
+ */
+void enable ();
+
+/**
+ * @brief Forgets the totals gathered so far
+ */
+void reset ();
+
+/**
+ * @brief Gets the totals gathered since the last reset, longest first
+ */
+std::vector< category_total > get ();
+
+} // namespace totals
+
 namespace counter {
 
 /**
@@ -162,8 +229,29 @@ void value (const Category& category, float value);
 
 } // namespace tracing
 
+// The tracing scopes compiled in, set with --enable-tracing at configure time:
+//
+//   0  none, the scopes cost nothing at all
+//   1  the per-frame and per-subsystem scopes of TRACE_SCOPE
+//   2  also the per-object scopes of the inner loops, TRACE_DETAIL_SCOPE, and
+//      the monitors
+//
+#ifndef FS2_TRACING_LEVEL
+#define FS2_TRACING_LEVEL 1
+#endif // FS2_TRACING_LEVEL
+
+#if FS2_TRACING_LEVEL >= 1
 #define TRACE_SCOPE(category)                            \
     ::tracing::complete::ScopedCompleteEvent FS2_PASTE ( \
         complete_trace_scope, __LINE__) (category)
+#else
+#define TRACE_SCOPE(category) ((void)0)
+#endif // FS2_TRACING_LEVEL >= 1
+
+#if FS2_TRACING_LEVEL >= 2
+#define TRACE_DETAIL_SCOPE(category) TRACE_SCOPE (category)
+#else
+#define TRACE_DETAIL_SCOPE(category) ((void)0)
+#endif // FS2_TRACING_LEVEL >= 2
 
 #endif // FREESPACE2_TRACING_TRACING_HH
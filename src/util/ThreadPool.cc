@@ -0,0 +1,103 @@
+// -*- mode: c++; -*-
+
+#include "defs.hh"
+#include "cmdline/cmdline.hh"
+#include "util/ThreadPool.hh"
+
+namespace util {
+
+ThreadPool::ThreadPool (size_t workers) : _next (0) {
+    for (size_t i = 0; i < workers; ++i) {
+        _threads.emplace_back (&ThreadPool::run, this);
+    }
+}
+
+ThreadPool::~ThreadPool () {
+    {
+        std::lock_guard< std::mutex > guard (_mutex);
+        _quit = true;
+    }
+
+    _wake.notify_all ();
+
+    for (auto& thread : _threads) { thread.join (); }
+}
+
+size_t ThreadPool::size () const { return _threads.size () + 1; }
+
+void ThreadPool::work () {
+    for (;;) {
+        size_t first = _next.fetch_add (_grain);
+
+        if (first >= _count) { break; }
+
+        (*_function) (first, (std::min) (first + _grain, _count));
+    }
+}
+
+void ThreadPool::run () {
+    std::uint64_t generation = 0;
+
+    for (;;) {
+        std::unique_lock< std::mutex > lock (_mutex);
+
+        _wake.wait (
+            lock, [&]() { return _quit || _generation != generation; });
+
+        if (_quit) { return; }
+
+        generation = _generation;
+
+        lock.unlock ();
+        work ();
+        lock.lock ();
+
+        if (--_busy == 0) { _done.notify_one (); }
+    }
+}
+
+void ThreadPool::parallel_for (
+    size_t count, size_t grain, const RangeFunction& function) {
+    if (count == 0) { return; }
+
+    if (grain == 0) { grain = 1; }
+
+    if (_threads.empty () || count <= grain) {
+        function (0, count);
+        return;
+    }
+
+    {
+        std::lock_guard< std::mutex > guard (_mutex);
+
+        _function = &function;
+        _count = count;
+        _grain = grain;
+        _next = 0;
+
+        _busy = _threads.size ();
+        ++_generation;
+    }
+
+    _wake.notify_all ();
+
+    work ();
+
+    std::unique_lock< std::mutex > lock (_mutex);
+    _done.wait (lock, [this]() { return _busy == 0; });
+
+    _function = nullptr;
+}
+
+ThreadPool& worker_pool () {
+    static ThreadPool pool ([]() -> size_t {
+        if (Cmdline_threads >= 0) { return size_t (Cmdline_threads); }
+
+        unsigned cores = std::thread::hardware_concurrency ();
+        return cores > 1 ? cores - 1 : 0;
+    }());
+
+    return pool;
+}
+
+} // namespace util
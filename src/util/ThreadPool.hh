@@ -0,0 +1,85 @@
+// -*- mode: c++; -*-
+
+#ifndef FREESPACE2_UTIL_THREADPOOL_HH
+#define FREESPACE2_UTIL_THREADPOOL_HH
+
+#include "defs.hh"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+/**
+ * @brief A fixed set of worker threads for data-parallel simulation stages
+ *
+ * The calling thread takes part in the work and parallel_for only returns
+ * once every index has been processed, so the work function may refer to
+ * data on the caller's stack. The pool must only be driven from one thread
+ * at a time and the work function must not call parallel_for itself.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief A function processing the indices [first, last)
+     */
+    typedef std::function< void(size_t, size_t) > RangeFunction;
+
+private:
+    std::vector< std::thread > _threads;
+
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+
+    const RangeFunction* _function = nullptr;
+    size_t _count = 0;
+    size_t _grain = 1;
+    std::atomic< size_t > _next;
+
+    size_t _busy = 0;
+    std::uint64_t _generation = 0;
+    bool _quit = false;
+
+    void work ();
+    void run ();
+
+public:
+    /**
+     * @brief Starts the worker threads
+     * @param workers The number of threads to start in addition to the
+     * calling thread; zero runs all the work on the calling thread
+     */
+    explicit ThreadPool (size_t workers);
+    ~ThreadPool ();
+
+    ThreadPool (const ThreadPool&) = delete;
+    ThreadPool& operator= (const ThreadPool&) = delete;
+
+    /**
+     * @brief The number of threads taking part in parallel_for, including
+     * the calling thread
+     */
+    size_t size () const;
+
+    /**
+     * @brief Calls function over the indices [0, count) in chunks of at most
+     * grain indices, spread over all the threads of the pool
+     */
+    void
+    parallel_for (size_t count, size_t grain, const RangeFunction& function);
+};
+
+/**
+ * @brief The engine-wide worker pool, sized by the -threads command line
+ * option
+ */
+ThreadPool& worker_pool ();
+
+} // namespace util
+
+#endif // FREESPACE2_UTIL_THREADPOOL_HH
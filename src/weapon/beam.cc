@@ -2498,10 +2498,23 @@ int beam_collide_ship (obj_pair* pair) {
     // check all three kinds of collisions
     int shield_collision =
         (pm->shield.ntris > 0) ? model_collide (&mc_shield) : 0;
-    int hull_enter_collision = model_collide (&mc_hull_enter);
-    int hull_exit_collision = (beam_will_tool_target (b, ship_objp))
-                                  ? model_collide (&mc_hull_exit)
-                                  : 0;
+    int hull_enter_collision = 0;
+    int hull_exit_collision = 0;
+
+    if (beam_will_tool_target (b, ship_objp)) {
+        // the entry and exit rays go through the model together
+        mc_info mc_hull[2] = { mc_hull_enter, mc_hull_exit };
+        model_collide_packet (mc_hull, 2);
+
+        mc_hull_enter = mc_hull[0];
+        mc_hull_exit = mc_hull[1];
+
+        hull_enter_collision = mc_hull_enter.num_hits;
+        hull_exit_collision = mc_hull_exit.num_hits;
+    }
+    else {
+        hull_enter_collision = model_collide (&mc_hull_enter);
+    }
 
     // If we have a range less than the "far" range, check if the ray actually
     // hit within the range
@@ -7,6 +7,7 @@
 #include "io/timer.hh"
 #include "model/modelrender.hh"
 #include "object/object.hh"
+#include "object/objectgrid.hh"
 #include "render/3d.hh"
 #include "render/batching.hh"
 #include "ship/ship.hh"
@@ -280,8 +281,17 @@ void shockwave_move (object* shockwave_objp, float frametime) {
 
     // blast ships and asteroids
     // And (some) weapons
-    for (objp = GET_FIRST (&obj_used_list);
-         objp != END_OF_LIST (&obj_used_list); objp = GET_NEXT (objp)) {
+    std::vector< int > candidates;
+
+    obj_grid_query_sphere (
+        &sw->pos, sw->radius * OBJ_GRID_QUICK_DIST_SCALE,
+        OBJ_GRID_TYPE (OBJ_SHIP) | OBJ_GRID_TYPE (OBJ_ASTEROID) |
+            OBJ_GRID_TYPE (OBJ_WEAPON),
+        OBJ_GRID_ALL_TEAMS, candidates);
+
+    for (int objnum : candidates) {
+        objp = &Objects[objnum];
+
         if ((objp->type != OBJ_SHIP) && (objp->type != OBJ_ASTEROID) &&
             (objp->type != OBJ_WEAPON)) {
             continue;
@@ -283,7 +283,7 @@ void trail_render (trail* trailp) {
     if ((nv % 2) != 1)
         WARNINGF (LOCATION, "even number of verts in trail render");
 
-    TRACE_SCOPE (tracing::TrailDraw);
+    TRACE_DETAIL_SCOPE (tracing::TrailDraw);
     // gr_set_bitmap( ti->texture.bitmap_id, GR_ALPHABLEND_FILTER,
     // GR_BITBLT_MODE_NORMAL, 1.0f ); gr_render(nv, Trail_v_list,
     // TMAP_FLAG_TEXTURED | TMAP_FLAG_ALPHA | TMAP_FLAG_GOURAUD | TMAP_FLAG_RGB
@@ -21,6 +21,7 @@
 #include "math/prng.hh"
 #include "missionui/missionweaponchoice.hh"
 #include "object/objcollide.hh"
+#include "object/objectgrid.hh"
 #include "particle/effects/BeamPiercingEffect.hh"
 #include "particle/effects/ParticleEmitterEffect.hh"
 #include "particle/effects/SingleParticleEffect.hh"
@@ -3749,12 +3750,22 @@ void detonate_nearby_missiles (object* killer_objp, object* missile_objp) {
         return;
     }
 
-    missile_obj* mop = GET_FIRST (&Missile_obj_list);
+    std::vector< int > candidates;
 
-    while (mop != END_OF_LIST (&Missile_obj_list)) {
-        object* objp = &Objects[mop->objnum];
+    obj_grid_query_sphere (
+        &killer_objp->pos,
+        killer_infop->cm_detonation_rad * OBJ_GRID_QUICK_DIST_SCALE,
+        OBJ_GRID_TYPE (OBJ_WEAPON),
+        iff_get_attackee_mask (Weapons[killer_objp->instance].team),
+        candidates);
+
+    for (int objnum : candidates) {
+        object* objp = &Objects[objnum];
         weapon* wp = &Weapons[objp->instance];
 
+        // only the missiles
+        if (wp->missile_list_index < 0) { continue; }
+
         if (iff_x_attacks_y (Weapons[killer_objp->instance].team, wp->team)) {
             if (Missiontime - wp->creation_time > F1_0 / 2) {
                 if (vm_vec_dist_quick (&killer_objp->pos, &objp->pos) <
@@ -3766,8 +3777,6 @@ void detonate_nearby_missiles (object* killer_objp, object* missile_objp) {
                 }
             }
         }
-
-        mop = mop->next;
     }
 }
 
@@ -3792,7 +3801,8 @@ void find_homing_object (object* weapon_objp, int num) {
 
     wp->homing_object = &obj_used_list;
 
-    // Scan all objects, find a weapon to home on.
+    // Scan all objects, find a weapon to home on. The search is not bounded
+    // by a range, so a grid query would visit every object anyway.
     for (objp = GET_FIRST (&obj_used_list);
          objp != END_OF_LIST (&obj_used_list); objp = GET_NEXT (objp)) {
         if ((objp->type == OBJ_SHIP) ||